@@ -0,0 +1,73 @@
+// Coroutine form of the pivot search.
+//
+// Each search suspends after issuing a prefetch for its next midpoint.
+// A scheduler resumes a fixed number of searches round-robin, so each
+// search's load has landed by the time it runs again, and refills a
+// slot from the queue as soon as its search completes.  Unlike the
+// lock-step batch, short searches do not hold a slot idle while long
+// ones finish.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef CORO_SEARCH_H
+#define CORO_SEARCH_H
+
+#include <coroutine>
+#include <cstddef>
+
+#include "find_pivot.h"
+
+// PivotSearch
+// Handle to a suspended pivot search coroutine
+class PivotSearch {
+ public:
+  struct promise_type {
+    INDEX pivot = 0;
+
+    PivotSearch get_return_object()
+    {
+      return PivotSearch(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_value(INDEX p) { pivot = p; }
+    void unhandled_exception();
+
+    // Frames are recycled through a free list to keep allocation off the
+    // per-search path
+    static void *operator new(size_t bytes);
+    static void operator delete(void *frame, size_t bytes);
+  };
+
+  PivotSearch() : handle_(nullptr) {}
+  PivotSearch(PivotSearch &&other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+  PivotSearch &operator=(PivotSearch &&other) noexcept;
+  PivotSearch(const PivotSearch &) = delete;
+  PivotSearch &operator=(const PivotSearch &) = delete;
+  ~PivotSearch();
+
+  bool Done() const { return handle_.done(); }
+  void Resume() { handle_.resume(); }
+  INDEX Pivot() const { return handle_.promise().pivot; }
+
+ private:
+  explicit PivotSearch(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Constants
+const UINT CORO_WIDTH = 32;             // searches kept in flight
+
+PivotSearch FindRampPivotCoro(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+void FindRampStartInterleaved(
+    const RampRef *ramps,
+    UINT count,
+    INDEX *starts,
+    UINT *tries = nullptr,
+    UINT width = CORO_WIDTH);
+
+#endif // CORO_SEARCH_H
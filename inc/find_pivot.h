@@ -0,0 +1,158 @@
+// Shared definitions for the rotated ramp pivot finder.
+//
+// The container is a sorted ascending ramp that has been rotated
+// to begin at an arbitrary point in the array buffer.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef FIND_PIVOT_H
+#define FIND_PIVOT_H
+
+#include <cstdint>
+
+// Definitions
+typedef __int64_t SIZE;         // element counts; arrays may exceed 4G elements
+typedef __uint64_t INDEX;       // element positions returned by the engines
+typedef __uint32_t UINT;
+typedef UINT CONTAINER;
+
+// Constants
+const unsigned INCREMENT_BOUND = 4;
+const SIZE BENCH_MAX_SIZE = 10000000;   // largest size the benchmark sweeps use; not a container limit
+const UINT SCAN_WINDOW = 64;            // elements; four 64-byte cache lines
+const UINT BATCH_GROUP = 32;            // searches advanced together per level
+const UINT KARY_WAYS = 8;               // separators per level of ENGINE_KARY
+const SIZE PARALLEL_GENERATE = 1 << 22; // elements from which the driver generates in parallel
+
+// PivotEngine
+// Selects the search engine used behind FindRampStart
+enum PivotEngine {
+  ENGINE_RECURSIVE,       // recursive bisection with early exits
+  ENGINE_BRANCHLESS,      // fixed-step bisection using conditional moves
+  ENGINE_HYBRID,          // branchless bisection, vector scan of the last window
+  ENGINE_PLATEAU,         // duplicate-correct bisection, vector scan of plateaus
+  ENGINE_DENSE,           // closed form for unit-step ramps, verified, else plateau
+  ENGINE_KARY,            // KARY_WAYS separators per level, one vector compare
+  ENGINE_SERIAL           // plateau bisection in serial-number order (wrapping values)
+};
+
+// ScanIsa
+// Instruction sets for the final-stage descent scan, narrowest first
+enum ScanIsa {
+  SCAN_SCALAR,
+  SCAN_AVX2,
+  SCAN_AVX512
+};
+
+// Container management
+void FreeContainer(const CONTAINER *container);
+CONTAINER *AllocContainer(SIZE size);
+SIZE MirroredSize(SIZE size);
+CONTAINER *AllocMirroredContainer(SIZE size);
+void FreeMirroredContainer(const CONTAINER *container, SIZE size);
+void PrintContainer(CONTAINER *container, SIZE size);
+void GenerateRamp(CONTAINER *container, SIZE size, INDEX startIdx, bool dupes, CONTAINER base = 0);
+void GenerateRampParallel(
+    CONTAINER *container,
+    SIZE size,
+    INDEX startIdx,
+    bool dupes,
+    CONTAINER base = 0,
+    UINT threads = 0);
+void GeneratePlateauRamp(CONTAINER *container, SIZE size, INDEX startIdx, double density);
+
+// Pivot search
+INDEX FindRampPivot(
+    const CONTAINER *container,
+    INDEX left_idx,
+    INDEX right_idx,
+    UINT *tries);
+INDEX FindRampPivotBranchless(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+INDEX FindRampPivotHybrid(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+INDEX FindRampPivotPlateau(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+INDEX FindRampPivotDense(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+INDEX FindRunEndLinear(const CONTAINER *container, SIZE size, INDEX idx);
+INDEX FindRunEnd(const CONTAINER *container, SIZE size, INDEX idx);
+INDEX PivotToStart(const CONTAINER *container, SIZE size, INDEX pivot);
+INDEX FindRampStart(
+    CONTAINER *container,
+    SIZE size,
+    UINT *tries,
+    PivotEngine engine = ENGINE_RECURSIVE);
+INDEX FindRampStartFromHint(
+    const CONTAINER *container,
+    SIZE size,
+    INDEX hint,
+    UINT *tries);
+INDEX FindRampStartSerial(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+INDEX FindRampStartStrided(
+    const void *records,
+    SIZE size,
+    UINT stride,
+    UINT keyOffset,
+    UINT *tries);
+
+// Batched search (batch.cc)
+struct RampRef {
+  const CONTAINER *container;
+  SIZE size;
+};
+void FindRampStartBatch(
+    const RampRef *ramps,
+    UINT count,
+    INDEX *starts,
+    UINT *tries = nullptr);
+
+// Descent scan (descent_scan.cc)
+ScanIsa DetectScanIsa();
+bool SetScanIsa(ScanIsa isa);
+INDEX FindDescent(const CONTAINER *container, INDEX count);
+INDEX FindNotEqual(const CONTAINER *container, INDEX count, CONTAINER value);
+INDEX FindRampPivotKary(
+    const CONTAINER *container,
+    SIZE size,
+    UINT ways,
+    UINT *tries);
+
+// Benchmarks (bench.cc)
+int RunBenchmark(const char *name, int argc, char *argv[]);
+void PrintBenchmarks();
+
+#include "rotated_search.h"
+
+// CONTAINER plateaus are crossed with the vectorized scan
+template <>
+struct ramp::ScanTraits<CONTAINER, std::less<CONTAINER>> {
+  template <typename Index>
+  static Index NotEqual(const CONTAINER *container, Index count, CONTAINER value, std::less<CONTAINER>)
+  {
+    return FindNotEqual(container, count, value);
+  }
+};
+
+// Serial-number order compares equality the same way
+template <>
+struct ramp::ScanTraits<CONTAINER, ramp::SerialLess<CONTAINER>> {
+  template <typename Index>
+  static Index NotEqual(const CONTAINER *container, Index count, CONTAINER value, ramp::SerialLess<CONTAINER>)
+  {
+    return FindNotEqual(container, count, value);
+  }
+};
+
+#endif // FIND_PIVOT_H
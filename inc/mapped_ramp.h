@@ -0,0 +1,46 @@
+// Pivot search over a file of CONTAINER values mapped into memory.
+//
+// The largest ramps live in files rather than in AllocContainer memory.
+// MapRamp maps such a file read-only with MADV_RANDOM, so a fault brings
+// in only the page touched instead of a readahead window.  The paged
+// search then bisects over the first element of each page, so every level
+// touches exactly one new page, and finishes inside the single page that
+// holds the pivot.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef MAPPED_RAMP_H
+#define MAPPED_RAMP_H
+
+#include <cstddef>
+
+#include "find_pivot.h"
+
+// MappedRamp
+// A read-only mapping of a ramp file
+struct MappedRamp {
+  int fd;
+  const CONTAINER *container;
+  SIZE size;                    // elements
+  size_t bytes;                 // length of the mapping
+};
+
+// PageStats
+// Process counters for sizing the page cache
+struct PageStats {
+  long minor_faults;            // pages mapped from the page cache
+  long major_faults;            // pages that needed I/O
+  unsigned long long read_bytes;  // bytes read from storage (0 if unknown)
+};
+
+bool MapRamp(const char *path, MappedRamp *ramp, bool random = true);
+void UnmapRamp(MappedRamp *ramp);
+void DropRampPages(const MappedRamp *ramp);
+bool WriteRampFile(const char *path, SIZE size, INDEX startIdx);
+INDEX FindRampPivotPaged(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries);
+void ReadPageStats(PageStats *stats);
+
+#endif // MAPPED_RAMP_H
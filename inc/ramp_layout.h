@@ -0,0 +1,339 @@
+// Cache-friendly layouts for read-mostly rotated ramps.
+//
+// Bisection over the linear layout touches a different cache line (and
+// at the top levels a different page) at every step.  For buffers that
+// are written once and then searched many times, the ramp can be
+// re-laid once into an order where consecutive search steps are close
+// together:
+//
+//   EytzingerRamp - the physical order stored as an implicit binary tree
+//                   in breadth-first order.  The four levels below a node
+//                   share one cache line, so it is prefetched while the
+//                   current compare resolves.
+//   BTreeRamp     - the physical order stored as leaf blocks of one cache
+//                   line, under levels of separator blocks of the same
+//                   size (a static B+ tree).  Each level costs one line,
+//                   searched with a branchless count.  The root block is
+//                   prefetched while the last leaf is checked, and each
+//                   child block as soon as the count picks it.
+//
+// Both keep the physical order of the source container, so the pivot and
+// the (tag, value) order of LowerBoundSinglePass are monotonic predicates
+// over it and each search is a single descent.  ToLinear writes the
+// physical order back out.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef RAMP_LAYOUT_H
+#define RAMP_LAYOUT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "rotated_search.h"
+
+namespace ramp {
+
+const size_t LAYOUT_LINE = 64;          // bytes per cache line
+
+// CacheAligned
+// Allocator placing the first element on a cache line boundary
+template <typename T>
+struct CacheAligned {
+  typedef T value_type;
+
+  CacheAligned() = default;
+  template <typename U>
+  CacheAligned(const CacheAligned<U> &) {}
+
+  T *allocate(size_t count)
+  {
+    return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(LAYOUT_LINE)));
+  }
+  void deallocate(T *ptr, size_t)
+  {
+    ::operator delete(ptr, std::align_val_t(LAYOUT_LINE));
+  }
+
+  template <typename U>
+  bool operator==(const CacheAligned<U> &) const { return true; }
+  template <typename U>
+  bool operator!=(const CacheAligned<U> &) const { return false; }
+};
+
+// EytzingerRamp
+// Rotated ramp stored in breadth-first (Eytzinger) order.  Slot 0 is
+// unused so the children of slot k are 2k and 2k + 1, and the sixteen
+// descendants four levels down, 16k..16k + 15, fill one aligned line for
+// 4-byte keys.
+template <typename T, typename Index, typename Compare = std::less<T>>
+class EytzingerRamp {
+ public:
+  EytzingerRamp() : size_(0), height_(0), start_(0) {}
+
+  // Build
+  // Re-lay a rotated ramp
+  // Entry: pointer to container
+  //        size of container in elements (> 0)
+  //        comparator
+  void Build(const T *container, Index size, Compare comp = Compare())
+  {
+    comp_ = comp;
+    size_ = size;
+    tree_.assign((size_t) size + 1, container[ 0 ]);
+    height_ = 0;
+    while (((Index) 2 << height_) - 1 < size)
+      height_++;
+    Index i = 0;
+    Fill(container, 1, &i);
+    start_ = FindStart();
+  }
+
+  // FindPivot
+  // Entry: pointer to tries (may be nullptr)
+  // Exit: pivot
+  Index FindPivot(Index *tries = nullptr) const
+  {
+    Index start = FindStart(tries);
+    return start ? start - 1 : size_ - 1;
+  }
+
+  // FindStart
+  // Entry: pointer to tries (may be nullptr)
+  // Exit: index in the source container of the smallest element
+  Index FindStart(Index *tries = nullptr) const
+  {
+    KeyArg<T> first = tree_[ Leftmost() ];
+    Index idx = PartitionPoint([&](const T &elem) { return !comp_(elem, first); }, tries);
+    return idx == size_ ? 0 : idx;
+  }
+
+  // LowerBound
+  // Entry: key
+  // Exit: logical offset of the first element not less than key, size if
+  //       every element is less (as ramp::LowerBound)
+  Index LowerBound(KeyArg<T> key, Index *tries = nullptr) const
+  {
+    BeforeKey<T, Compare> before(tree_[ Leftmost() ], key, comp_);
+    Index slot;
+    Index idx = PartitionPoint(before, tries, &slot);
+    return BoundToLogical(idx < size_ ? &tree_[ slot ] : nullptr, idx, before, size_, start_);
+  }
+
+  // ToLinear
+  // Entry: pointer to container of Size() elements (out), in the
+  //        physical order of the source
+  void ToLinear(T *container) const
+  {
+    for (Index k = 1; k <= size_; k++)
+      container[ Rank(k) ] = tree_[ k ];
+  }
+
+  Index Size() const { return size_; }
+  Index Start() const { return start_; }
+
+ private:
+  // Fill
+  // In-order walk writing the next source element at each slot
+  void Fill(const T *container, Index k, Index *i)
+  {
+    if (k > size_)
+      return;
+    Fill(container, 2 * k, i);
+    tree_[ k ] = container[ (*i)++ ];
+    Fill(container, 2 * k + 1, i);
+  }
+
+  // Leftmost
+  // Exit: slot holding physical index 0, the first slot of the deepest
+  //       level
+  Index Leftmost() const
+  {
+    return (Index) 1 << height_;
+  }
+
+  // Rank
+  // In-order position of slot k.  In a full tree of the same height the
+  // slot at depth d and offset p in its level has position
+  // (2p + 1) 2^(height - d) - 1; the missing leaves of the last level,
+  // which take the even positions, are then discounted.
+  // Entry: slot (1..size)
+  // Exit: physical index
+  Index Rank(Index k) const
+  {
+    Index depth = 63 - __builtin_clzll((unsigned long long) k);
+    Index full = ((2 * (k - ((Index) 1 << depth)) + 1) << (height_ - depth)) - 1;
+    Index leaves = size_ - (((Index) 1 << height_) - 1);
+    Index before = (full + 1) / 2;
+    return full - (before - (before < leaves ? before : leaves));
+  }
+
+  // PartitionPoint
+  // Descend to the first element, in physical order, for which pred is
+  // false.  The compare picks the child with a conditional move; the
+  // line holding the node's great-great-grandchildren is prefetched
+  // while it resolves.
+  // Entry: monotonic predicate, true then false in physical order
+  //        pointer to tries (may be nullptr)
+  //        pointer to the slot found (may be nullptr)
+  // Exit: physical index of the first element for which pred is false,
+  //       size if there is none
+  template <typename Pred>
+  Index PartitionPoint(Pred pred, Index *tries = nullptr, Index *slot = nullptr) const
+  {
+    const T *tree = tree_.data();
+    size_t k = 1;
+    Index steps = 0;
+    while (k <= size_) {
+      // In the last four levels 16 * k is past the array, and even
+      // forming that pointer is undefined
+      __builtin_prefetch(tree + std::min<size_t>(16 * k, size_));
+      k = 2 * k + pred(tree[ k ]);
+      steps++;
+    }
+    if (tries)
+      *tries += steps;
+    // Undo the right turns taken after the last left turn
+    k >>= __builtin_ffsll(~(unsigned long long) k);
+    if (slot)
+      *slot = (Index) k;
+    return k ? Rank((Index) k) : size_;
+  }
+
+  std::vector<T, CacheAligned<T>> tree_;
+  Index size_;
+  Index height_;
+  Index start_;
+  Compare comp_;
+};
+
+// BTreeRamp
+// Rotated ramp stored as a static B+ tree of one-line blocks.  Level 0
+// holds the physical order in blocks of B elements; each higher level
+// holds the last element of every block below it.  The last block of
+// each level is padded with its last real key, which lets every block
+// be searched at full width.
+template <typename T, typename Index, typename Compare = std::less<T>,
+         Index B = (LAYOUT_LINE / sizeof(T) > 1 ? LAYOUT_LINE / sizeof(T) : 2)>
+class BTreeRamp {
+ public:
+  BTreeRamp() : size_(0), start_(0) {}
+
+  // Build
+  // Entry/Exit: as EytzingerRamp::Build
+  void Build(const T *container, Index size, Compare comp = Compare())
+  {
+    comp_ = comp;
+    size_ = size;
+
+    // Level sizes in blocks, bottom up, then lay the levels out top down
+    std::vector<Index> blocks;
+    Index keys = size;
+    do {
+      blocks.push_back((keys + B - 1) / B);
+      keys = blocks.back();
+    } while (keys > 1);
+    offsets_.assign(blocks.size(), 0);
+    size_t total = 0;
+    for (size_t l = blocks.size(); l-- > 0;) {
+      offsets_[ l ] = total;
+      total += (size_t) blocks[ l ] * B;
+    }
+    tree_.assign(total, container[ size - 1 ]);
+
+    T *leaves = tree_.data() + offsets_[ 0 ];
+    for (Index i = 0; i < size; i++)
+      leaves[ i ] = container[ i ];
+    for (size_t l = 1; l < blocks.size(); l++) {
+      const T *below = tree_.data() + offsets_[ l - 1 ];
+      T *level = tree_.data() + offsets_[ l ];
+      for (Index j = 0; j < blocks[ l - 1 ]; j++)
+        level[ j ] = below[ (size_t) j * B + B - 1 ];
+      for (Index j = blocks[ l - 1 ]; j < blocks[ l ] * B; j++)
+        level[ j ] = level[ blocks[ l - 1 ] - 1 ];
+    }
+    start_ = FindStart();
+  }
+
+  // FindPivot
+  // Entry/Exit: as EytzingerRamp::FindPivot
+  Index FindPivot(Index *tries = nullptr) const
+  {
+    Index start = FindStart(tries);
+    return start ? start - 1 : size_ - 1;
+  }
+
+  // FindStart
+  // Entry/Exit: as EytzingerRamp::FindStart
+  Index FindStart(Index *tries = nullptr) const
+  {
+    KeyArg<T> first = tree_[ offsets_[ 0 ] ];
+    Index idx = PartitionPoint([&](const T &elem) { return !comp_(elem, first); }, tries);
+    return idx == size_ ? 0 : idx;
+  }
+
+  // LowerBound
+  // Entry/Exit: as EytzingerRamp::LowerBound
+  Index LowerBound(KeyArg<T> key, Index *tries = nullptr) const
+  {
+    const T *leaves = tree_.data() + offsets_[ 0 ];
+    BeforeKey<T, Compare> before(leaves[ 0 ], key, comp_);
+    Index idx = PartitionPoint(before, tries);
+    return BoundToLogical(idx < size_ ? &leaves[ idx ] : nullptr, idx, before, size_, start_);
+  }
+
+  // ToLinear
+  // Entry/Exit: as EytzingerRamp::ToLinear
+  void ToLinear(T *container) const
+  {
+    const T *leaves = tree_.data() + offsets_[ 0 ];
+    for (Index i = 0; i < size_; i++)
+      container[ i ] = leaves[ i ];
+  }
+
+  Index Size() const { return size_; }
+  Index Start() const { return start_; }
+
+ private:
+  // PartitionPoint
+  // Descend one block per level, counting the keys for which pred holds.
+  // The count is branchless over the whole block so it vectorizes.  The
+  // root block is prefetched before the last leaf is checked, and each
+  // child block before the loop moves down to count it.
+  // Entry/Exit: as EytzingerRamp::PartitionPoint
+  template <typename Pred>
+  Index PartitionPoint(Pred pred, Index *tries = nullptr) const
+  {
+    // Either pred holds for every element or the last one fails it.  In
+    // the second case each block descended into ends in a failing key, so
+    // its padding is never counted.
+    if (tries)
+      *tries += (Index) offsets_.size() + 1;
+    __builtin_prefetch(tree_.data() + offsets_.back());
+    if (pred(tree_[ offsets_[ 0 ] + size_ - 1 ]))
+      return size_;
+    size_t block = 0;
+    for (size_t l = offsets_.size(); l-- > 0;) {
+      const T *keys = tree_.data() + offsets_[ l ] + block * B;
+      Index count = 0;
+      for (Index j = 0; j < B; j++)
+        count += pred(keys[ j ]);
+      block = block * B + count;
+      if (l)
+        __builtin_prefetch(tree_.data() + offsets_[ l - 1 ] + block * B);
+    }
+    return (Index) block;
+  }
+
+  std::vector<T, CacheAligned<T>> tree_;
+  std::vector<size_t> offsets_;         // first key of each level, leaves first
+  Index size_;
+  Index start_;
+  Compare comp_;
+};
+
+} // namespace ramp
+
+#endif // RAMP_LAYOUT_H
@@ -0,0 +1,213 @@
+// Pivot prediction for ramps with smooth value distributions.
+//
+// Bisection ignores the values it reads beyond their order.  When values
+// are spread smoothly over the ramp, the position of the ramp start can be
+// estimated from a few of them, and the search then only has to cover a
+// bounded window around the estimate (FindPivotWindow) instead of the
+// whole container.
+//
+// Two predictors are provided:
+//   interpolation - three probes and a linear model anchored at the
+//                   ramp's smallest value; no state
+//   RampModel     - a piecewise-linear map from value to logical rank,
+//                   fitted once per buffer with a measured error bound,
+//                   so later lookups need only the container[ 0 ] probe
+//                   before the windowed search
+//
+// Both need arithmetic keys and unique values.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef RAMP_MODEL_H
+#define RAMP_MODEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "rotated_search.h"
+
+namespace ramp {
+
+// FindPivotAround
+// Search a window of +/- error elements around a predicted pivot
+// Entry: pointer to container
+//        size of container in elements
+//        predicted pivot
+//        error bound
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index>
+Index FindPivotAround(
+    const T *container,
+    Index size,
+    Index guess,
+    Index error,
+    Index *tries = nullptr)
+{
+  Index lo = guess > error ? guess - error : 0;
+  Index hi = size - 1 - guess > error ? guess + error : size - 1;
+  return FindPivotWindow(container, size, lo, hi, std::less<T>(), tries);
+}
+
+// StartToPivot
+// Entry: estimated ramp start (may lie outside [0, size))
+//        size of container in elements
+// Exit: pivot, the element before the rounded start
+template <typename Index>
+inline Index StartToPivot(double start, Index size)
+{
+  double rounded = std::floor(start + 0.5);
+  if (!(rounded >= 0.0))
+    rounded = 0.0;
+  Index idx = rounded >= (double) size ? 0 : (Index) rounded;
+  return idx ? idx - 1 : size - 1;
+}
+
+// PredictPivotInterpolation
+// Estimate the pivot from container[ 0 ], the midpoint, container[ size - 1 ]
+// and the ramp's smallest value.  The midpoint's segment supplies the
+// density (elements per unit of value); counting from base to the value
+// at a known position then locates the start.
+// Entry: pointer to container
+//        size of container in elements
+//        smallest value in the ramp
+//        pointer to tries (may be nullptr)
+// Exit: predicted pivot
+template <typename T, typename Index>
+Index PredictPivotInterpolation(
+    const T *container,
+    Index size,
+    T base,
+    Index *tries = nullptr)
+{
+  static_assert(std::is_arithmetic<T>::value, "interpolation needs arithmetic keys");
+  if (size < 3)
+    return size - 1;
+  if (tries)
+    *tries += 3;
+  const Index mid = size >> 1;
+  const double first = container[ 0 ];
+  const double middle = container[ mid ];
+  const double last = container[ size - 1 ];
+
+  double start;
+  if (middle > first) {
+    // Midpoint is before the seam: count the elements below container[ 0 ]
+    double density = mid / (middle - first);
+    start = size - (first - (double) base) * density;
+  } else if (last > middle) {
+    // Midpoint is after the seam: count back from it to base
+    double density = (size - 1 - mid) / (last - middle);
+    start = mid - (middle - (double) base) * density;
+  } else {
+    return mid;
+  }
+  return StartToPivot(start, size);
+}
+
+// FindPivotInterpolated
+// Entry: pointer to container
+//        size of container in elements
+//        smallest value in the ramp
+//        half-width of the window searched around the prediction
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index>
+Index FindPivotInterpolated(
+    const T *container,
+    Index size,
+    T base,
+    Index error,
+    Index *tries = nullptr)
+{
+  Index guess = PredictPivotInterpolation(container, size, base, tries);
+  return FindPivotAround(container, size, guess, error, tries);
+}
+
+// RampModel
+// Piecewise-linear map from value to logical rank for one buffer.  Fit
+// samples evenly spaced knots in logical order and measures the worst
+// prediction error over every element, so a lookup on the same buffer (or
+// any rotation of the same values) searches a window that is known to
+// hold the pivot.
+template <typename T, typename Index>
+class RampModel {
+  static_assert(std::is_arithmetic<T>::value, "RampModel needs arithmetic keys");
+
+ public:
+  RampModel() : size_(0), error_(0) {}
+
+  // Fit
+  // Entry: pointer to container
+  //        size of container in elements
+  //        ramp start (from FindStart)
+  //        number of linear pieces
+  void Fit(const T *container, Index size, Index start, Index pieces = 64)
+  {
+    size_ = size;
+    values_.clear();
+    ranks_.clear();
+    if (pieces > size - 1)
+      pieces = size > 1 ? size - 1 : 1;
+    for (Index k = 0; k <= pieces; k++) {
+      Index rank = (Index) ((double) k * (size - 1) / pieces + 0.5);
+      if (!ranks_.empty() && rank == (Index) ranks_.back())
+        continue;
+      values_.push_back(container[ ToPhysical(start, rank, size) ]);
+      ranks_.push_back(rank);
+    }
+
+    double worst = 0.0;
+    for (Index rank = 0; rank < size; rank++) {
+      double err = std::fabs(Rank(container[ ToPhysical(start, rank, size) ]) - rank);
+      worst = err > worst ? err : worst;
+    }
+    error_ = (Index) std::ceil(worst) + 1;
+  }
+
+  // Rank
+  // Entry: value
+  // Exit: predicted logical rank of value
+  double Rank(T value) const
+  {
+    auto it = std::upper_bound(values_.begin(), values_.end(), value);
+    if (it == values_.begin())
+      return ranks_.front();
+    if (it == values_.end())
+      return ranks_.back();
+    size_t k = (size_t) (it - values_.begin()) - 1;
+    double span = (double) values_[ k + 1 ] - (double) values_[ k ];
+    return ranks_[ k ] + ((double) value - (double) values_[ k ]) / span * (ranks_[ k + 1 ] - ranks_[ k ]);
+  }
+
+  // PredictPivot
+  // Entry: pointer to container (only container[ 0 ] is read)
+  // Exit: predicted pivot
+  Index PredictPivot(const T *container) const
+  {
+    return StartToPivot(size_ - Rank(container[ 0 ]), size_);
+  }
+
+  // FindPivot
+  // Entry: pointer to a container of the fitted size
+  //        pointer to tries (may be nullptr)
+  // Exit: pivot
+  Index FindPivot(const T *container, Index *tries = nullptr) const
+  {
+    return FindPivotAround(container, size_, PredictPivot(container), error_, tries);
+  }
+
+  Index Error() const { return error_; }
+
+ private:
+  std::vector<T> values_;
+  std::vector<double> ranks_;
+  Index size_;
+  Index error_;
+};
+
+} // namespace ramp
+
+#endif // RAMP_MODEL_H
@@ -0,0 +1,95 @@
+// Ring buffer that keeps its ramp start.
+//
+// A raw container from AllocContainer carries no state, so every consumer
+// re-derives the ramp start with a pivot search.  RotatedRamp owns the
+// container and moves the start along as values are pushed: once the
+// buffer is full each push overwrites the oldest element, and the start
+// is simply the slot after the newest.  Head lookups cost nothing on the
+// common path.
+//
+// The pivot search is only needed when the contents were written behind
+// the buffer's back - a bulk load into Data() or a buffer restored after a
+// crash - and Recover() rebuilds the start from them.
+//
+// Pushed values must not be less than the newest value, or the buffer is
+// no longer a ramp.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef ROTATED_RAMP_H
+#define ROTATED_RAMP_H
+
+#include <cassert>
+
+#include "find_pivot.h"
+#include "rotated_view.h"
+
+// RotatedRamp
+// Fixed-capacity ring of CONTAINER values in ascending order
+class RotatedRamp {
+ public:
+  explicit RotatedRamp(SIZE capacity);
+  ~RotatedRamp();
+  RotatedRamp(const RotatedRamp &) = delete;
+  RotatedRamp &operator=(const RotatedRamp &) = delete;
+
+  // Push
+  // Append a value, overwriting the oldest once the buffer is full
+  // Entry: value, not less than Back()
+  void Push(CONTAINER value)
+  {
+    assert(!size_ || value >= Back());
+    container_[ tail_ ] = value;
+    tail_ = tail_ + 1 == (INDEX) capacity_ ? 0 : tail_ + 1;
+    if (size_ < capacity_)
+      size_++;
+    else
+      start_ = tail_;
+  }
+
+  // Start
+  // Exit: index in Data() of the oldest (smallest) value
+  INDEX Start() const { return start_; }
+
+  // operator[]
+  // Entry: logical position, 0 being the oldest value
+  // Exit: value
+  CONTAINER operator[](INDEX pos) const
+  {
+    assert(pos < (INDEX) size_);
+    INDEX idx = start_ + pos;
+    return container_[ idx >= (INDEX) capacity_ ? idx - capacity_ : idx ];
+  }
+
+  CONTAINER Front() const { return container_[ start_ ]; }
+  CONTAINER Back() const { return container_[ tail_ ? tail_ - 1 : capacity_ - 1 ]; }
+  SIZE Size() const { return size_; }
+  SIZE Capacity() const { return capacity_; }
+  bool Full() const { return size_ == capacity_; }
+
+  // View
+  // Exit: the values in logical order, oldest first, without a copy.
+  // Valid until the next Push, Recover or Clear.
+  ramp::RotatedView<const CONTAINER, INDEX> View() const
+  {
+    return ramp::RotatedView<const CONTAINER, INDEX>(container_, size_, start_);
+  }
+
+  // Data
+  // The underlying container, in physical order.  After writing to it
+  // directly, call Recover().
+  CONTAINER *Data() { return container_; }
+  const CONTAINER *Data() const { return container_; }
+
+  INDEX Recover(bool dupes = true, UINT *tries = nullptr);
+  void Clear();
+
+ private:
+  CONTAINER *container_;
+  SIZE capacity_;
+  SIZE size_;
+  INDEX start_;           // oldest value
+  INDEX tail_;            // slot the next push writes
+};
+
+#endif // ROTATED_RAMP_H
@@ -0,0 +1,625 @@
+// Header-only rotated ramp search, generic over element type, comparator
+// and index type.
+//
+// The container is a ramp sorted ascending under the comparator and
+// rotated to begin at an arbitrary point.  Every function is a template,
+// so each element type gets its own instantiation with the comparison
+// inlined; for uint32 keys under std::less the generated code is the
+// same as the hand-written CONTAINER engines, which are now thin wrappers
+// over these templates.
+//
+// Scans over plateaus of equal keys go through ScanTraits, which may be
+// specialized for a type to supply a vectorized implementation.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef ROTATED_SEARCH_H
+#define ROTATED_SEARCH_H
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace ramp {
+
+// KeyArg
+// Small trivially copyable keys are held by value so the search keeps
+// them in a register; larger keys are held by reference.
+template <typename T>
+using KeyArg = typename std::conditional<
+    std::is_trivially_copyable<T>::value && sizeof(T) <= 16, T, const T &>::type;
+
+// Equal
+// Equivalence under a strict weak ordering
+template <typename T, typename Compare>
+inline bool Equal(const T &a, const T &b, Compare comp)
+{
+  return !comp(a, b) && !comp(b, a);
+}
+
+// SerialLess
+// RFC 1982 serial-number order for unsigned sequence numbers that wrap:
+// a is before b when b - a, taken modulo 2^bits, is below half the range.
+// The order is a strict weak ordering over any set of values spanning
+// less than half the range, so a ring whose live values span less than
+// 2^31 can straddle the numeric wrap point and still be searched; the
+// comparison is one subtraction and a sign test.
+template <typename T>
+struct SerialLess {
+  bool operator()(T a, T b) const
+  {
+    return (typename std::make_signed<T>::type) (a - b) < 0;
+  }
+};
+
+// ScanTraits
+// Linear scans used when bisection cannot make progress.  Specialize for
+// a (type, comparator) pair to supply a faster implementation.
+template <typename T, typename Compare>
+struct ScanTraits {
+  // NotEqual
+  // Entry: pointer to first element
+  //        number of elements to compare
+  //        value to skip
+  //        comparator
+  // Exit: offset of the first element not equivalent to value, count if
+  //       there is none
+  template <typename Index>
+  static Index NotEqual(const T *container, Index count, KeyArg<T> value, Compare comp)
+  {
+    for (Index i = 0; i < count; i++) {
+      if (!Equal<T>(container[ i ], value, comp))
+        return i;
+    }
+    return count;
+  }
+};
+
+// FindPivot
+// Find the pivot (the last element before the ramp start) with a fixed
+// ceil(log2 n) conditional-move halvings.  Every element before the ramp
+// start is not less than container[ 0 ] and every element from the ramp
+// start onward is less than it, so the pivot is the last index with
+// !comp(container[ i ], container[ 0 ]).  Keys must be unique.
+// Entry: pointer to container
+//        size of container in elements
+//        comparator
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindPivot(
+    const T *container,
+    Index size,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  KeyArg<T> first = container[ 0 ];
+  const T *base = container;
+  Index n = size;
+  Index steps = 0;
+  while (n > 1) {
+    Index half = n >> 1;
+    base = !comp(base[ half ], first) ? base + half : base;
+    n -= half;
+    steps++;
+  }
+  if (tries)
+    *tries += steps + 1;     // halvings plus the container[ 0 ] probe
+  return (Index) (base - container);
+}
+
+// FindPivotPlateau
+// Duplicate-correct pivot search.  When both window ends and the midpoint
+// are equivalent the window is an ambiguous plateau, which is crossed with
+// ScanTraits::NotEqual instead of guessing which half holds the descent.
+// Entry: pointer to container
+//        size of container in elements
+//        comparator
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindPivotPlateau(
+    const T *container,
+    Index size,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  Index lo = 0;
+  Index hi = size - 1;
+  while (lo < hi) {
+    if (tries)
+      (*tries)++;
+    // An ascending window holds no descent; the ramp starts at lo
+    if (comp(container[ lo ], container[ hi ]))
+      break;
+    Index mid = lo + ((hi - lo) >> 1);
+    if (comp(container[ hi ], container[ mid ])) {
+      lo = mid + 1;
+    } else if (comp(container[ mid ], container[ lo ])) {
+      hi = mid;
+    } else {
+      // container[ lo ], container[ mid ] and container[ hi ] are equivalent
+      KeyArg<T> value = container[ lo ];
+      Index off = ScanTraits<T, Compare>::NotEqual(container + lo, hi - lo + 1, value, comp);
+      if (off > hi - lo || comp(container[ lo + off ], value)) {
+        // No descent inside the plateau, or the plateau ends in one
+        lo += off > hi - lo ? 0 : off;
+        break;
+      }
+      // The plateau rises; the descent lies beyond it
+      lo += off;
+    }
+  }
+  return (lo + size - 1) % size;
+}
+
+// FindPivotDense
+// Constant-time pivot for dense ramps, whose values step by exactly one
+// from base (sequence numbers).  Then container[ 0 ] - base is the number
+// of places container[ 0 ] lies past the ramp start, which gives the
+// start directly.  The guess is confirmed with two probes: the start must
+// hold base and be preceded by a descent.  A rotated ramp has only one
+// descent, so a confirmed guess is correct for any ramp; when the check
+// fails the search falls back to FindPivotPlateau.
+// Entry: pointer to container
+//        size of container in elements
+//        smallest value in the ramp
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index>
+Index FindPivotDense(
+    const T *container,
+    Index size,
+    T base,
+    Index *tries = nullptr)
+{
+  static_assert(std::is_integral<T>::value, "dense ramps hold integer values");
+  typedef typename std::make_unsigned<T>::type Rank;
+
+  if (tries)
+    (*tries)++;
+  Rank rank = (Rank) container[ 0 ] - (Rank) base;
+  if (container[ 0 ] >= base && (unsigned long long) rank < (unsigned long long) size) {
+    Index start = rank ? size - (Index) rank : 0;
+    Index pivot = start ? start - 1 : size - 1;
+    if (tries)
+      *tries += 2;
+    if (container[ start ] == base && container[ start ] < container[ pivot ])
+      return pivot;
+  }
+  return FindPivotPlateau(container, size, std::less<T>(), tries);
+}
+
+// FindPivotWindow
+// Find the pivot within a window [lo, hi] predicted to hold it, in
+// ceil(log2 (hi - lo + 1)) conditional-move halvings.  The window brackets
+// the pivot when container[ lo ] is not less than container[ 0 ] and
+// either hi is the last element or container[ hi ] is less than
+// container[ 0 ]; if it does not, the search falls back to FindPivot
+// over the whole container.  Keys must be unique.
+// Entry: pointer to container
+//        size of container in elements
+//        first index of the window
+//        last index of the window
+//        comparator
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindPivotWindow(
+    const T *container,
+    Index size,
+    Index lo,
+    Index hi,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  KeyArg<T> first = container[ 0 ];
+  if (tries)
+    *tries += 3;          // container[ 0 ] and the two window ends
+  if (hi >= size || lo > hi || comp(container[ lo ], first) ||
+      (hi < size - 1 && !comp(container[ hi ], first)))
+    return FindPivot(container, size, comp, tries);
+
+  const T *base = container + lo;
+  Index n = hi - lo + 1;
+  while (n > 1) {
+    Index half = n >> 1;
+    base = !comp(base[ half ], first) ? base + half : base;
+    n -= half;
+    if (tries)
+      (*tries)++;
+  }
+  return (Index) (base - container);
+}
+
+// FindPivotFromHint
+// Find the pivot starting from a previous pivot, in O(log k) probes when
+// the pivot has since moved k places in either direction.
+//
+// Read cyclically forward from the hint, the container holds values not
+// less than container[ hint ] up to the pivot and values less than it
+// after; read backward, values not greater than it down to the element
+// after the pivot and greater values from the pivot on.  Both are
+// monotonic, so the search gallops alternately forward and backward with
+// doubling steps, then bisects the first bracket found.  Keys must be
+// unique.
+// Entry: pointer to container
+//        size of container in elements
+//        previous pivot
+//        comparator
+//        pointer to tries (may be nullptr)
+// Exit: pivot
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindPivotFromHint(
+    const T *container,
+    Index size,
+    Index hint,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  if (hint >= size)
+    hint %= size;
+  KeyArg<T> value = container[ hint ];
+  auto forward = [&](Index off) {
+    Index idx = hint + off;
+    return container[ idx >= size ? idx - size : idx ];
+  };
+  auto backward = [&](Index off) {
+    return container[ hint >= off ? hint - off : hint + size - off ];
+  };
+  Index probes = 1;
+
+  // Gallop: *_lo stays on the hint's side of the pivot
+  const Index last = size - 1;
+  Index fwd_lo = 0, fwd_step = 1, fwd_hi = size;
+  Index bwd_lo = 0, bwd_step = 1, bwd_hi = 0;
+  for (;;) {
+    if (fwd_step > last - fwd_lo)
+      break;
+    probes++;
+    if (comp(forward(fwd_lo + fwd_step), value)) {
+      fwd_hi = fwd_lo + fwd_step;
+      break;
+    }
+    fwd_lo += fwd_step;
+    fwd_step <<= 1;
+
+    if (bwd_step <= last - bwd_lo) {
+      probes++;
+      if (comp(value, backward(bwd_lo + bwd_step))) {
+        bwd_hi = bwd_lo + bwd_step;
+        break;
+      }
+      bwd_lo += bwd_step;
+      bwd_step <<= 1;
+    }
+  }
+
+  Index pivot;
+  if (bwd_hi) {
+    // Bisect (bwd_lo, bwd_hi) for the first element greater than the hint
+    while (bwd_hi - bwd_lo > 1) {
+      Index mid = bwd_lo + ((bwd_hi - bwd_lo) >> 1);
+      probes++;
+      if (comp(value, backward(mid)))
+        bwd_hi = mid;
+      else
+        bwd_lo = mid;
+    }
+    pivot = hint >= bwd_hi ? hint - bwd_hi : hint + size - bwd_hi;
+  } else {
+    // Bisect (fwd_lo, fwd_hi) for the last element not less than the hint
+    while (fwd_hi - fwd_lo > 1) {
+      Index mid = fwd_lo + ((fwd_hi - fwd_lo) >> 1);
+      probes++;
+      if (comp(forward(mid), value))
+        fwd_hi = mid;
+      else
+        fwd_lo = mid;
+    }
+    pivot = hint + fwd_lo;
+    pivot = pivot >= size ? pivot - size : pivot;
+  }
+  if (tries)
+    *tries += probes;
+  return pivot;
+}
+
+// FindRunEndLinear
+// Scan forward, wrapping at the end of the buffer, to the last element of
+// the run of entries equivalent to container[ idx ].
+// Entry: pointer to container
+//        size of container in elements
+//        index of an element in the run
+//        comparator
+// Exit: index of the last element of the run; size - 1 if every element
+//       is equivalent
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindRunEndLinear(const T *container, Index size, Index idx, Compare comp = Compare())
+{
+  KeyArg<T> value = container[ idx ];
+  Index tail = size - idx - 1;
+  Index off = ScanTraits<T, Compare>::NotEqual(container + idx + 1, tail, value, comp);
+  if (off < tail)
+    return idx + off;
+  off = ScanTraits<T, Compare>::NotEqual(container, idx, value, comp);
+  if (off < idx)
+    return (off + size - 1) % size;
+  return size - 1;
+}
+
+// FindRunEnd
+// Find the last element of the run of entries equivalent to
+// container[ idx ] in O(log k) probes for a run of length k, by galloping
+// forward from idx and then bisecting between the last equal and first
+// unequal probe.
+//
+// Equivalent keys form one contiguous run in a rotated ramp, so within
+// [idx, size - 1] the run is a prefix and the search is monotonic.  The
+// exception is a run that straddles the end of the buffer: the unequal
+// gap may then sit anywhere, cannot be found by bisection, and the linear
+// scan is used.
+// Entry: pointer to container
+//        size of container in elements
+//        index of an element in the run
+//        comparator
+// Exit: index of the last element of the run
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindRunEnd(const T *container, Index size, Index idx, Compare comp = Compare())
+{
+  KeyArg<T> value = container[ idx ];
+  const Index last = size - 1;
+  if (Equal<T>(container[ 0 ], value, comp) && Equal<T>(container[ last ], value, comp))
+    return FindRunEndLinear(container, size, idx, comp);
+
+  // Gallop: lo stays in the run, step doubles until a probe leaves it
+  Index lo = idx;
+  Index hi = size;
+  Index step = 1;
+  while (step <= last - lo) {
+    if (!Equal<T>(container[ lo + step ], value, comp)) {
+      hi = lo + step;
+      break;
+    }
+    lo += step;
+    step <<= 1;
+  }
+
+  // Bisect (lo, hi) for the last element still in the run
+  while (hi - lo > 1) {
+    Index mid = lo + ((hi - lo) >> 1);
+    if (Equal<T>(container[ mid ], value, comp))
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// PivotToStart
+// Step from the pivot over any repeated entries to the ramp start
+// Entry: pointer to container
+//        size of container in elements
+//        pivot
+//        comparator
+// Exit: ramp start
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index PivotToStart(const T *container, Index size, Index pivot, Compare comp = Compare())
+{
+  return (FindRunEnd(container, size, pivot, comp) + 1) % size;
+}
+
+// FindStart
+// Find the ramp start of a container of unique keys
+// Entry: pointer to container
+//        size of container in elements (> 0)
+//        comparator
+//        pointer to tries (may be nullptr)
+// Exit: index of the smallest element
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindStart(
+    const T *container,
+    Index size,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  return PivotToStart(container, size, FindPivot(container, size, comp, tries), comp);
+}
+
+// FindStartFromHint
+// Find the ramp start of a container of unique keys given the start found
+// by an earlier lookup
+// Entry: pointer to container
+//        size of container in elements (> 0)
+//        previous ramp start
+//        comparator
+//        pointer to tries (may be nullptr)
+// Exit: index of the smallest element
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindStartFromHint(
+    const T *container,
+    Index size,
+    Index hint,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  Index pivot_hint = (hint % size) ? (hint % size) - 1 : size - 1;
+  return PivotToStart(container, size, FindPivotFromHint(container, size, pivot_hint, comp, tries), comp);
+}
+
+// FindStartDuplicates
+// Find the ramp start of a container that may hold repeated keys
+// Entry/Exit: as FindStart
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index FindStartDuplicates(
+    const T *container,
+    Index size,
+    Compare comp = Compare(),
+    Index *tries = nullptr)
+{
+  return PivotToStart(container, size, FindPivotPlateau(container, size, comp, tries), comp);
+}
+
+// Key searches
+//
+// The following search for a key in the logical (unrotated) order of the
+// ramp without moving any data.  Positions are logical offsets from the
+// ramp start in [0, size]; ToPhysical maps an offset below size back to
+// an index into the container.
+
+// ToPhysical
+// Entry: ramp start
+//        logical offset (< size)
+//        size of container in elements
+// Exit: index into the container
+template <typename Index>
+inline Index ToPhysical(Index start, Index offset, Index size)
+{
+  Index idx = start + offset;
+  return idx >= size ? idx - size : idx;
+}
+
+// LowerBound
+// Find the first element not less than key.  The rotated container is two
+// ascending segments, [start, size) followed logically by [0, start); the
+// last element of the first segment decides which one holds the bound, so
+// the cost is one binary search over that segment.
+// Entry: pointer to container
+//        size of container in elements
+//        ramp start (from FindStart)
+//        key
+//        comparator
+// Exit: logical offset of the bound, size if every element is less
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index LowerBound(
+    const T *container,
+    Index size,
+    Index start,
+    KeyArg<T> key,
+    Compare comp = Compare())
+{
+  if (!start)
+    return (Index) (std::lower_bound(container, container + size, key, comp) - container);
+  if (!comp(container[ size - 1 ], key))
+    return (Index) (std::lower_bound(container + start, container + size, key, comp) - container) - start;
+  return (size - start) + (Index) (std::lower_bound(container, container + start, key, comp) - container);
+}
+
+// UpperBound
+// Find the first element greater than key.  container[ 0 ], the first
+// element of the second segment, decides which segment holds the bound.
+// Entry/Exit: as LowerBound
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index UpperBound(
+    const T *container,
+    Index size,
+    Index start,
+    KeyArg<T> key,
+    Compare comp = Compare())
+{
+  if (!start)
+    return (Index) (std::upper_bound(container, container + size, key, comp) - container);
+  if (comp(key, container[ 0 ]))
+    return (Index) (std::upper_bound(container + start, container + size, key, comp) - container) - start;
+  return (size - start) + (Index) (std::upper_bound(container, container + start, key, comp) - container);
+}
+
+// EqualRange
+// Entry/Exit: as LowerBound; returns the logical [lower, upper) offsets of
+//             the elements equivalent to key
+template <typename T, typename Index, typename Compare = std::less<T>>
+std::pair<Index, Index> EqualRange(
+    const T *container,
+    Index size,
+    Index start,
+    KeyArg<T> key,
+    Compare comp = Compare())
+{
+  return std::make_pair(
+      LowerBound(container, size, start, key, comp),
+      UpperBound(container, size, start, key, comp));
+}
+
+// LowerBoundSinglePass
+// Find the first element not less than key in one binary search, without
+// locating the ramp start.  Tagging each element with whether it falls
+// below container[ 0 ] (and so lies in the segment after the seam) makes
+// the physical order sorted by (tag, value), and the key is tagged the
+// same way.  Requires that no element after the seam equals
+// container[ 0 ], which always holds for unique keys.
+// Entry: pointer to container
+//        size of container in elements (> 0)
+//        key
+//        comparator
+// Exit: index into the container of the bound, size if every element
+//       is less than key
+template <typename T, typename Index, typename Compare = std::less<T>>
+Index LowerBoundSinglePass(
+    const T *container,
+    Index size,
+    KeyArg<T> key,
+    Compare comp = Compare())
+{
+  KeyArg<T> first = container[ 0 ];
+  const bool key_low = comp(key, first);
+  const T *bound = std::partition_point(container, container + size,
+      [&](const T &elem) {
+        bool elem_low = comp(elem, first);
+        return elem_low == key_low ? comp(elem, key) : elem_low < key_low;
+      });
+  Index idx = (Index) (bound - container);
+
+  // A high key past the last high element has run into the low segment,
+  // or off the end of an unrotated container: every element is less
+  if (!key_low)
+    return idx < size && comp(container[ idx ], first) ? size : idx;
+  // A low key past the last low element continues at the high segment
+  return idx == size ? 0 : idx;
+}
+
+// BeforeKey
+// Predicate over the physical order of a rotated ramp that is true for
+// the elements before the lower bound of key, as LowerBoundSinglePass
+// orders them
+template <typename T, typename Compare>
+struct BeforeKey {
+  KeyArg<T> first;
+  KeyArg<T> key;
+  bool key_low;
+  Compare comp;
+
+  BeforeKey(KeyArg<T> f, KeyArg<T> k, Compare c) : first(f), key(k), key_low(c(k, f)), comp(c) {}
+
+  bool operator()(const T &elem) const
+  {
+    bool elem_low = comp(elem, first);
+    return elem_low == key_low ? comp(elem, key) : elem_low < key_low;
+  }
+};
+
+// BoundToLogical
+// Convert the physical index from a BeforeKey search to a logical offset
+// Entry: pointer to the element at the physical bound (nullptr if none)
+//        physical bound
+//        predicate used for the search
+//        size of container in elements
+//        ramp start
+// Exit: logical offset of the bound, size if every element is less
+template <typename T, typename Index, typename Compare>
+Index BoundToLogical(const T *elem, Index idx, const BeforeKey<T, Compare> &before, Index size, Index start)
+{
+  // As LowerBoundSinglePass: a high key that runs into the low segment, or
+  // a low key that runs off the end, wraps to the other segment
+  if (!before.key_low) {
+    if (idx == size || before.comp(*elem, before.first))
+      return size;
+  } else if (idx == size) {
+    idx = 0;
+  }
+  return idx >= start ? idx - start : idx + size - start;
+}
+
+} // namespace ramp
+
+#endif // ROTATED_SEARCH_H
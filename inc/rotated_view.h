@@ -0,0 +1,200 @@
+// Header-only zero-copy view of a rotated ramp in logical order.
+//
+// RotatedView presents container[ start .. size ) followed by
+// container[ 0 .. start ) as one ascending sequence without moving any
+// data.  Its iterators are random access, mapping a logical position to
+// a physical index with a compare and a conditional subtract instead of a
+// modulo, so std::lower_bound, std::for_each and the ranges algorithms run
+// on the buffer in place.
+//
+// A whole-range walk does not need even that: the view is two contiguous
+// segments, and ForEachSegment / ForEach visit them with plain pointer
+// loops that the compiler can vectorize.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef ROTATED_VIEW_H
+#define ROTATED_VIEW_H
+
+#include <algorithm>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+namespace ramp {
+
+// RotatedView
+// T may be const-qualified for a read-only view
+template <typename T, typename Index = size_t>
+class RotatedView {
+ public:
+  typedef T value_type;
+  typedef Index size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  // iterator
+  // Logical position over the view; physical index start + pos, wrapped.
+  // The iterator holds its own copy of the view, so it stays valid after
+  // the view it came from is gone.
+  class iterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef std::random_access_iterator_tag iterator_concept;
+    typedef std::remove_cv_t<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+
+    iterator() : pos_(0) {}
+    iterator(const RotatedView &view, Index pos) : view_(view), pos_(pos) {}
+
+    T &operator*() const { return view_.At(pos_); }
+    T *operator->() const { return &view_.At(pos_); }
+    T &operator[](difference_type n) const { return view_.At(pos_ + n); }
+
+    iterator &operator++() { ++pos_; return *this; }
+    iterator operator++(int) { iterator it = *this; ++pos_; return it; }
+    iterator &operator--() { --pos_; return *this; }
+    iterator operator--(int) { iterator it = *this; --pos_; return it; }
+    iterator &operator+=(difference_type n) { pos_ += n; return *this; }
+    iterator &operator-=(difference_type n) { pos_ -= n; return *this; }
+    iterator operator+(difference_type n) const { return iterator(view_, pos_ + n); }
+    iterator operator-(difference_type n) const { return iterator(view_, pos_ - n); }
+    friend iterator operator+(difference_type n, const iterator &it) { return it + n; }
+    difference_type operator-(const iterator &other) const
+    {
+      return (difference_type) pos_ - (difference_type) other.pos_;
+    }
+
+    bool operator==(const iterator &other) const { return pos_ == other.pos_; }
+    auto operator<=>(const iterator &other) const { return pos_ <=> other.pos_; }
+
+    // Position
+    // Exit: logical position
+    Index Position() const { return pos_; }
+
+    // Physical
+    // Exit: index into the container
+    Index Physical() const { return view_.ToPhysical(pos_); }
+
+   private:
+    RotatedView view_;
+    Index pos_;
+  };
+  typedef iterator const_iterator;
+
+  RotatedView() : container_(nullptr), size_(0), start_(0) {}
+
+  // RotatedView
+  // Entry: pointer to container
+  //        size of container in elements
+  //        ramp start (index of the smallest element, < size or 0)
+  RotatedView(T *container, Index size, Index start)
+    : container_(container), size_(size), start_(start)
+  {
+    assert(!size || start < size);
+  }
+
+  // FromPivot
+  // Entry: pointer to container
+  //        size of container in elements (> 0)
+  //        pivot (last element before the ramp start), from a search on
+  //        unique keys
+  // Exit: view
+  static RotatedView FromPivot(T *container, Index size, Index pivot)
+  {
+    return RotatedView(container, size, pivot + 1 < size ? pivot + 1 : 0);
+  }
+
+  // ToPhysical
+  // Entry: logical position (< size)
+  // Exit: index into the container
+  Index ToPhysical(Index pos) const
+  {
+    Index idx = start_ + pos;
+    return idx >= size_ ? idx - size_ : idx;
+  }
+
+  // ToLogical
+  // Entry: index into the container
+  // Exit: logical position
+  Index ToLogical(Index idx) const
+  {
+    return idx >= start_ ? idx - start_ : idx + (size_ - start_);
+  }
+
+  T &At(Index pos) const { return container_[ ToPhysical(pos) ]; }
+  T &operator[](Index pos) const { return At(pos); }
+  T &front() const { return container_[ start_ ]; }
+  T &back() const { return At(size_ - 1); }
+
+  iterator begin() const { return iterator(*this, 0); }
+  iterator end() const { return iterator(*this, size_); }
+  Index size() const { return size_; }
+  bool empty() const { return !size_; }
+  Index Start() const { return start_; }
+  T *Data() const { return container_; }
+
+  // Head
+  // Exit: first contiguous segment, container[ start .. size )
+  std::span<T> Head() const { return std::span<T>(container_ + start_, size_ - start_); }
+
+  // Tail
+  // Exit: second contiguous segment, container[ 0 .. start )
+  std::span<T> Tail() const { return std::span<T>(container_, start_); }
+
+  // ForEachSegment
+  // Visit the two contiguous segments in logical order
+  // Entry: function taking (pointer to first element, number of elements)
+  template <typename F>
+  void ForEachSegment(F f) const
+  {
+    f(container_ + start_, size_ - start_);
+    if (start_)
+      f(container_, start_);
+  }
+
+  // ForEach
+  // Visit every element in logical order, a segment at a time
+  // Entry: function taking a reference to an element
+  template <typename F>
+  void ForEach(F f) const
+  {
+    ForEachSegment([&](T *p, Index n) {
+      for (Index i = 0; i < n; i++)
+        f(p[ i ]);
+    });
+  }
+
+  // CopyTo
+  // Copy the view out in logical order
+  // Entry: output iterator
+  // Exit: output iterator past the last element copied
+  template <typename Out>
+  Out CopyTo(Out out) const
+  {
+    ForEachSegment([&](T *p, Index n) { out = std::copy(p, p + n, out); });
+    return out;
+  }
+
+ private:
+  T *container_;
+  Index size_;
+  Index start_;
+};
+
+} // namespace ramp
+
+// Iterators do not refer back to the view, so ranges algorithms may
+// return them from a temporary view
+template <typename T, typename Index>
+inline constexpr bool std::ranges::enable_borrowed_range<ramp::RotatedView<T, Index>> = true;
+
+static_assert(std::random_access_iterator<ramp::RotatedView<const unsigned>::iterator>);
+static_assert(std::ranges::random_access_range<ramp::RotatedView<const unsigned>>);
+
+#endif // ROTATED_VIEW_H
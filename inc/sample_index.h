@@ -0,0 +1,193 @@
+// Sparse sample index for repeated searches of one large rotated ramp.
+//
+// The first levels of every bisection of a large container land on the
+// same few elements, each in its own cache line and usually its own page,
+// and other work evicts them between queries.  SampleIndex keeps every
+// stride-th element in a small contiguous array sized to stay in L1/L2.
+// A search resolves the stride-wide window holding the answer from the
+// samples, then bisects only that window of the container.  The position
+// of sample j is j * stride, so positions are not stored.
+//
+// The index describes one state of the container.  Update keeps it in
+// step with single-element writes; after wider changes call Refresh, or
+// Invalidate to make searches fall back to the plain ones.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef SAMPLE_INDEX_H
+#define SAMPLE_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+#include "rotated_search.h"
+
+namespace ramp {
+
+const size_t SAMPLE_INDEX_BYTES = 32768;    // default index budget, within L1d
+
+// SampleIndex
+// Every stride-th element of a rotated ramp of unique keys
+template <typename T, typename Index, typename Compare = std::less<T>>
+class SampleIndex {
+ public:
+  SampleIndex() : size_(0), shift_(0), valid_(false) {}
+
+  // Build
+  // Entry: pointer to container
+  //        size of container in elements (> 0)
+  //        stride, a power of two; 0 picks the smallest one whose index
+  //        fits in SAMPLE_INDEX_BYTES
+  //        comparator
+  void Build(const T *container, Index size, Index stride = 0, Compare comp = Compare())
+  {
+    comp_ = comp;
+    size_ = size;
+    shift_ = 0;
+    if (stride) {
+      while (((Index) 1 << shift_) < stride)
+        shift_++;
+    } else {
+      while ((((size_t) size >> shift_) + 1) * sizeof(T) > SAMPLE_INDEX_BYTES)
+        shift_++;
+    }
+    Refresh(container);
+  }
+
+  // Refresh
+  // Re-sample a container of the built size after it has changed
+  // Entry: pointer to container
+  void Refresh(const T *container)
+  {
+    samples_.resize(((size_ - 1) >> shift_) + 1);
+    for (Index j = 0; j < (Index) samples_.size(); j++)
+      samples_[ j ] = container[ (size_t) j << shift_ ];
+    valid_ = true;
+  }
+
+  // Assign
+  // Take samples saved from an index built over the same container
+  // Entry: size of container in elements
+  //        stride, a power of two
+  //        pointer to samples, ((size - 1) / stride) + 1 of them
+  //        comparator
+  void Assign(Index size, Index stride, const T *samples, Compare comp = Compare())
+  {
+    comp_ = comp;
+    size_ = size;
+    shift_ = 0;
+    while (((Index) 1 << shift_) < stride)
+      shift_++;
+    samples_.assign(samples, samples + ((size - 1) >> shift_) + 1);
+    valid_ = true;
+  }
+
+  // Update
+  // Follow a write of one element
+  // Entry: pointer to container
+  //        index of the element written
+  void Update(const T *container, Index idx)
+  {
+    if (!(idx & (((Index) 1 << shift_) - 1)))
+      samples_[ idx >> shift_ ] = container[ idx ];
+  }
+
+  // Invalidate
+  // Mark the index stale; searches fall back until the next Refresh
+  void Invalidate() { valid_ = false; }
+
+  bool Valid() const { return valid_; }
+  Index Stride() const { return (Index) 1 << shift_; }
+  size_t Bytes() const { return samples_.size() * sizeof(T); }
+  const std::vector<T> &Samples() const { return samples_; }
+
+  // FindPivot
+  // Entry: pointer to the indexed container
+  //        pointer to tries, probes of the container only (may be nullptr)
+  // Exit: pivot
+  Index FindPivot(const T *container, Index *tries = nullptr) const
+  {
+    if (!valid_)
+      return ramp::FindPivot(container, size_, comp_, tries);
+    KeyArg<T> first = samples_[ 0 ];
+    auto high = [&](const T &elem) { return !comp_(elem, first); };
+
+    // Window from the last high sample to the next sample
+    Index j = PartitionPoint(samples_.data(), (Index) samples_.size(), high) - 1;
+    Index lo = j << shift_;
+    Index end = j + 1 < (Index) samples_.size() ? lo + Stride() : size_;
+    return PartitionPoint(container + lo, end - lo, high, tries) + lo - 1;
+  }
+
+  // FindStart
+  // Entry/Exit: as FindPivot; returns the ramp start
+  Index FindStart(const T *container, Index *tries = nullptr) const
+  {
+    Index pivot = FindPivot(container, tries);
+    return pivot + 1 == size_ ? 0 : pivot + 1;
+  }
+
+  // LowerBound
+  // Entry: pointer to the indexed container
+  //        ramp start
+  //        key
+  //        pointer to tries, probes of the container only (may be nullptr)
+  // Exit: logical offset of the first element not less than key, size if
+  //       every element is less (as ramp::LowerBound)
+  Index LowerBound(const T *container, Index start, KeyArg<T> key, Index *tries = nullptr) const
+  {
+    if (!valid_)
+      return ramp::LowerBound(container, size_, start, key, comp_);
+    BeforeKey<T, Compare> before(samples_[ 0 ], key, comp_);
+
+    // The bound lies after the last sample before it, up to and including
+    // the next sample
+    Index j = PartitionPoint(samples_.data(), (Index) samples_.size(), before);
+    Index idx = 0;
+    if (j) {
+      Index lo = ((j - 1) << shift_) + 1;
+      Index end = j < (Index) samples_.size() ? (j << shift_) : size_;
+      idx = PartitionPoint(container + lo, end - lo, before, tries) + lo;
+    }
+    return BoundToLogical(idx < size_ ? &container[ idx ] : nullptr, idx, before, size_, start);
+  }
+
+ private:
+  // PartitionPoint
+  // Count the leading elements for which pred holds, with conditional-move
+  // halvings as FindPivot uses.  Both possible next midpoints are
+  // prefetched, so the window's cold lines are fetched a level ahead.
+  // Entry: pointer to first element
+  //        number of elements
+  //        monotonic predicate, true then false
+  //        pointer to tries (may be nullptr)
+  // Exit: number of leading elements for which pred holds
+  template <typename Pred>
+  static Index PartitionPoint(const T *base, Index n, Pred pred, Index *tries = nullptr)
+  {
+    const T *lo = base;
+    Index steps = 0;
+    while (n > 1) {
+      Index half = n >> 1;
+      __builtin_prefetch(lo + (half >> 1));
+      __builtin_prefetch(lo + half + (half >> 1));
+      lo = pred(lo[ half ]) ? lo + half : lo;
+      n -= half;
+      steps++;
+    }
+    Index count = (Index) (lo - base) + (n && pred(*lo));
+    if (tries)
+      *tries += steps + (n ? 1 : 0);
+    return count;
+  }
+
+  std::vector<T> samples_;
+  Index size_;
+  Index shift_;
+  bool valid_;
+  Compare comp_;
+};
+
+} // namespace ramp
+
+#endif // SAMPLE_INDEX_H
@@ -0,0 +1,44 @@
+// Oldest-record search over a circular log spread across segment files.
+//
+// A ring log written round-robin over N segment files is one logical
+// rotated ramp: the segments in write order, concatenated.  The oldest
+// record follows the seam, which is either a segment boundary or inside
+// the one segment being overwritten.  The first key of each segment
+// locates that segment by bisection, its last key says whether the seam
+// is inside it, and only then is the segment itself bisected, so a
+// search reads O(log N + log segment_size) records.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef SEGMENT_LOG_H
+#define SEGMENT_LOG_H
+
+#include <string>
+#include <vector>
+
+#include "find_pivot.h"
+
+// SegmentLog
+// Open segment files, in write order
+struct SegmentLog {
+  std::vector<int> fds;
+  std::vector<SIZE> sizes;      // records per segment
+};
+
+// LogPosition
+// A record in a segment log
+struct LogPosition {
+  UINT segment;
+  INDEX record;
+};
+
+bool OpenSegmentLog(const std::vector<std::string> &paths, SegmentLog *log);
+void CloseSegmentLog(SegmentLog *log);
+bool ReadLogRecord(const SegmentLog *log, LogPosition pos, CONTAINER *value);
+bool WriteSegmentLog(const std::vector<std::string> &paths, SIZE segmentSize, INDEX startIdx);
+bool FindOldestRecord(
+    const SegmentLog *log,
+    LogPosition *oldest,
+    UINT *reads);
+
+#endif // SEGMENT_LOG_H
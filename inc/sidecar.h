@@ -0,0 +1,39 @@
+// Persistent pivot index ("sidecar") for ramp files.
+//
+// Every process start would otherwise rediscover the ramp start of each
+// data file with a search of its own.  A sidecar, <file>.pivot, records
+// the start, the values either side of the seam, a sparse SampleIndex and
+// the data file's generation stamp (size, inode, modification time), all
+// under a checksum.  Loading it costs a stat and one read of the two
+// elements at the seam; anything that does not match falls back to the
+// search and rewrites the sidecar.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef SIDECAR_H
+#define SIDECAR_H
+
+#include <string>
+
+#include "find_pivot.h"
+#include "sample_index.h"
+
+// Constants
+const UINT SIDECAR_SAMPLES = 1024;      // most samples kept per sidecar
+
+// SidecarResult
+// Outcome of loading a ramp start through its sidecar
+enum SidecarResult {
+  SIDECAR_VALID,          // sidecar matched, start taken from it
+  SIDECAR_REBUILT,        // sidecar missing or stale; searched and rewritten
+  SIDECAR_FAILED          // data file unreadable
+};
+
+typedef ramp::SampleIndex<CONTAINER, INDEX> RampSamples;
+
+std::string SidecarPath(const char *path);
+bool WriteSidecar(const char *path, INDEX *start = nullptr, RampSamples *samples = nullptr);
+SidecarResult LoadRampStart(const char *path, INDEX *start, RampSamples *samples = nullptr);
+UINT BuildSidecars(const char *dir, UINT threads, UINT *failed);
+
+#endif // SIDECAR_H
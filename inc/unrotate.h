@@ -0,0 +1,46 @@
+// In-place unrotation of a ramp into physically sorted order.
+//
+// Rotating container[ 0 .. start ) behind container[ start .. size ) is
+// done by block swaps (Gries-Mills): swapping the shorter side with the
+// far end of the longer one puts it in its final place and leaves a
+// smaller rotation, until the shorter side fits a small buffer and the
+// rest is one shift.  Every pass is a sequential sweep over contiguous
+// ranges, and large swaps and shifts are split over threads.
+//
+// UnrotateCopy writes the sorted order to a separate buffer instead.  Its
+// destination is never read, so for buffers larger than the caches it
+// writes with non-temporal stores, which skip fetching each destination
+// line before overwriting it.  A swap reads both of its destinations
+// first, so streaming its stores gains nothing and measured slower.
+//
+// Where reading in logical order will do, ramp::RotatedView or
+// AllocMirroredContainer avoid moving anything.  `findramp bench
+// unrotate` compares this with std::rotate and with copying into a fresh
+// buffer.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef UNROTATE_H
+#define UNROTATE_H
+
+#include "find_pivot.h"
+
+// Constants
+const SIZE UNROTATE_BUFFER = 16384;     // shorter side moved through a buffer
+const SIZE UNROTATE_PARALLEL = 1 << 20; // elements from which a swap or shift is split over threads
+const SIZE UNROTATE_STREAM = 1 << 22;   // elements from which UnrotateCopy bypasses the caches
+
+void UnrotateContainer(CONTAINER *container, SIZE size, INDEX start, UINT threads = 0);
+void UnrotateCopy(
+    CONTAINER *dst,
+    const CONTAINER *container,
+    SIZE size,
+    INDEX start,
+    UINT threads = 0);
+INDEX UnrotateRamp(
+    CONTAINER *container,
+    SIZE size,
+    PivotEngine engine = ENGINE_PLATEAU,
+    UINT threads = 0);
+
+#endif // UNROTATE_H
@@ -0,0 +1,65 @@
+// Pivot search over ramp files read with O_DIRECT.
+//
+// When the file is not in the page cache every bisection level is a
+// blocking read.  The io_uring search reads k - 1 evenly spaced blocks
+// per round in parallel, so one round trip to storage narrows the range
+// of blocks by a factor of k.  Each block read also brings in a whole
+// block of elements, so a round ends the search early when the seam
+// falls inside a block just read.
+//
+// The ring is driven with the raw io_uring_setup / io_uring_enter
+// system calls; liburing is not needed.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#ifndef URING_SEARCH_H
+#define URING_SEARCH_H
+
+#include <cstddef>
+
+#include "find_pivot.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Constants
+const UINT URING_BLOCK = 4096;          // bytes per read, and buffer alignment
+const UINT URING_MAX_WAYS = 64;         // widest k-ary round
+
+// RampFile
+// A ramp file opened for direct I/O
+struct RampFile {
+  int fd;
+  SIZE size;                    // elements
+  size_t bytes;
+};
+
+// Uring
+// A submission/completion ring pair and one aligned buffer per entry
+struct Uring {
+  int fd;
+  UINT entries;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  io_uring_sqe *sqes;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  io_uring_cqe *cqes;
+  void *sq_ring, *cq_ring;
+  size_t sq_ring_bytes, cq_ring_bytes, sqes_bytes;
+  unsigned char *buffers;       // entries * URING_BLOCK bytes
+};
+
+bool OpenRampFile(const char *path, RampFile *file);
+void CloseRampFile(RampFile *file);
+bool UringInit(Uring *ring, UINT entries);
+void UringExit(Uring *ring);
+INDEX FindRampPivotPread(
+    const RampFile *file,
+    UINT *tries);
+INDEX FindRampPivotUring(
+    Uring *ring,
+    const RampFile *file,
+    UINT ways,
+    UINT *rounds,
+    UINT *reads = nullptr);
+
+#endif // URING_SEARCH_H
@@ -0,0 +1,86 @@
+// Batched pivot search over many independent ramps.
+//
+// A single lookup on a cold ramp stalls on memory at every halving.
+// Advancing a group of searches one level at a time and prefetching each
+// search's next midpoint as soon as it is known lets the loads of the
+// whole group be in flight together, so memory latency is paid once per
+// level instead of once per level per ramp.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <cassert>
+
+#include "find_pivot.h"
+
+// FindRampStartGroup
+// Run up to BATCH_GROUP branchless searches in lock step.  By the time a
+// search is revisited on the next level, the other searches in the group
+// have covered the latency of its prefetched midpoint.
+// Entry: pointer to ramps
+//        number of ramps (<= BATCH_GROUP)
+//        pointer to ramp starts (out)
+//        pointer to per-ramp tries (may be nullptr)
+static void FindRampStartGroup(
+    const RampRef *ramps,
+    UINT width,
+    INDEX *starts,
+    UINT *tries)
+{
+  const CONTAINER *base[ BATCH_GROUP ];
+  CONTAINER first[ BATCH_GROUP ];
+  INDEX n[ BATCH_GROUP ];
+  UINT steps[ BATCH_GROUP ];
+
+  // Level zero: every search needs container[ 0 ] and its first midpoint
+  for (UINT i = 0; i < width; i++) {
+    assert(ramps[ i ].size);
+    base[ i ] = ramps[ i ].container;
+    n[ i ] = ramps[ i ].size;
+    steps[ i ] = 0;
+    __builtin_prefetch(base[ i ]);
+    __builtin_prefetch(base[ i ] + (n[ i ] >> 1));
+  }
+  for (UINT i = 0; i < width; i++)
+    first[ i ] = base[ i ][ 0 ];
+
+  bool active = true;
+  while (active) {
+    active = false;
+    for (UINT i = 0; i < width; i++) {
+      if (n[ i ] <= 1)
+        continue;
+      INDEX half = n[ i ] >> 1;
+      base[ i ] = (base[ i ][ half ] >= first[ i ]) ? base[ i ] + half : base[ i ];
+      n[ i ] -= half;
+      steps[ i ]++;
+      __builtin_prefetch(base[ i ] + (n[ i ] >> 1));
+      active |= n[ i ] > 1;
+    }
+  }
+
+  for (UINT i = 0; i < width; i++) {
+    const CONTAINER *container = ramps[ i ].container;
+    starts[ i ] = PivotToStart(container, ramps[ i ].size, (INDEX) (base[ i ] - container));
+    if (tries)
+      tries[ i ] += steps[ i ] + 1;
+  }
+}
+
+// FindRampStartBatch
+// Find the ramp start of many independent containers at once.  Results
+// match FindRampStart with ENGINE_BRANCHLESS for each ramp.
+// Entry: pointer to ramps
+//        number of ramps
+//        pointer to ramp starts, one per ramp (out)
+//        pointer to tries, one per ramp, accumulated (may be nullptr)
+void FindRampStartBatch(
+    const RampRef *ramps,
+    UINT count,
+    INDEX *starts,
+    UINT *tries)
+{
+  for (UINT g = 0; g < count; g += BATCH_GROUP) {
+    UINT width = count - g < BATCH_GROUP ? count - g : BATCH_GROUP;
+    FindRampStartGroup(ramps + g, width, starts + g, tries ? tries + g : nullptr);
+  }
+}
@@ -0,0 +1,2093 @@
+// Benchmarks for the pivot search engines.
+//
+// Each benchmark is selected by name from the command line:
+//
+//   findramp bench <name> [args]
+//
+// Timings are only meaningful with the OPTIMIZED flags in the Makefile.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+#include "find_pivot.h"
+#include "coro_search.h"
+#include "mapped_ramp.h"
+#include "ramp_layout.h"
+#include "ramp_model.h"
+#include "record_search.h"
+#include "rotated_ramp.h"
+#include "rotated_view.h"
+#include "sample_index.h"
+#include "segment_log.h"
+#include "sidecar.h"
+#include "unrotate.h"
+#include "uring_search.h"
+
+// Sink for search results so the optimizer cannot discard the lookups
+static volatile UINT bench_sink;
+
+// NowNs
+// Exit: monotonic time in nanoseconds
+static double NowNs()
+{
+  return std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// NextBenchSize
+// Step through container sizes one at a time up to 16, then in
+// quarter-octave steps so the sweep covers 1..BENCH_MAX_SIZE evenly
+// on a log scale.
+// Entry: current size
+// Exit: next size
+static SIZE NextBenchSize(SIZE size)
+{
+  if (size < 16)
+    return size + 1;
+  SIZE next = (SIZE) (size * 1.189207);
+  if (next > BENCH_MAX_SIZE && size < BENCH_MAX_SIZE)
+    return BENCH_MAX_SIZE;
+  return next;
+}
+
+// TimeEngine
+// Time repeated lookups on one container with the given engine
+// Entry: pointer to container
+//        size of container
+//        engine
+//        number of lookups
+//        pointer to pivot found (out)
+// Exit: nanoseconds per lookup
+static double TimeEngine(
+    CONTAINER *container,
+    SIZE size,
+    PivotEngine engine,
+    UINT reps,
+    INDEX *idx)
+{
+  UINT tries = 0;
+  double start = NowNs();
+  for (UINT i = 0; i < reps; i++) {
+    *idx = FindRampStart(container, size, &tries, engine);
+    bench_sink = *idx;
+  }
+  return (NowNs() - start) / reps;
+}
+
+// EvictCaches
+// Stream through a scratch buffer larger than the last-level cache so the
+// next timed pass starts cold.
+// Entry: bytes to stream through
+static void EvictCaches(size_t bytes)
+{
+  static std::vector<UINT> scratch;
+  scratch.resize(bytes / sizeof(UINT));
+  UINT sum = 0;
+  for (size_t i = 0; i < scratch.size(); i += 16) {
+    scratch[ i ] += 1;
+    sum += scratch[ i ];
+  }
+  bench_sink = sum;
+}
+
+// RampPool
+// A set of independently rotated ramps of one size
+struct RampPool {
+  std::vector<CONTAINER *> containers;
+  std::vector<RampRef> ramps;
+  std::vector<INDEX> expected;
+};
+
+// BuildRampPool
+// Entry: size of each container
+//        number of containers
+//        pointer to pool (out)
+static void BuildRampPool(SIZE size, UINT count, RampPool *pool)
+{
+  for (UINT i = 0; i < count; i++) {
+    CONTAINER *container = AllocContainer(size);
+    INDEX startIdx = rand() % size;
+    GenerateRamp(container, size, startIdx, false);
+    pool->containers.push_back(container);
+    pool->ramps.push_back({ container, size });
+    pool->expected.push_back(startIdx);
+  }
+}
+
+// FreeRampPool
+// Entry: pointer to pool
+static void FreeRampPool(RampPool *pool)
+{
+  for (CONTAINER *container : pool->containers)
+    FreeContainer(container);
+  pool->containers.clear();
+  pool->ramps.clear();
+  pool->expected.clear();
+}
+
+// BenchPoolMb
+// Entry: remaining argument count
+//        remaining arguments
+//        default pool size
+// Exit: pool size in megabytes from the first argument, or the default
+static size_t BenchPoolMb(int argc, char *argv[], size_t default_mb)
+{
+  if (argc > 0 && strtoul(argv[ 0 ], nullptr, 10))
+    return strtoul(argv[ 0 ], nullptr, 10);
+  return default_mb;
+}
+
+// BenchEngines
+// Compare the recursive and branchless engines at every size from 1 to
+// BENCH_MAX_SIZE.  For each size the ramp is rotated to several evenly
+// spaced start positions; the min/max columns show how much the latency
+// depends on where the pivot sits.
+// Exit: 0 on success, nonzero if the engines disagree
+static int BenchEngines(int argc, char *argv[])
+{
+  const UINT LOOKUPS_PER_SIZE = 1 << 16;
+  const UINT MAX_ROTATIONS = 8;
+  UINT mismatches = 0;
+
+  printf("%10s %10s %10s %10s %10s %10s %10s %8s\n",
+      "size", "rec_ns", "rec_min", "rec_max",
+      "brl_ns", "brl_min", "brl_max", "speedup");
+  for (SIZE size = 1; size <= BENCH_MAX_SIZE; size = NextBenchSize(size)) {
+    CONTAINER *container = AllocContainer(size);
+    UINT rotations = (UINT) size < MAX_ROTATIONS ? size : MAX_ROTATIONS;
+    UINT reps = LOOKUPS_PER_SIZE / rotations;
+    double rec_sum = 0.0, rec_min = 1e30, rec_max = 0.0;
+    double brl_sum = 0.0, brl_min = 1e30, brl_max = 0.0;
+
+    for (UINT r = 0; r < rotations; r++) {
+      // Skip start 0; FindRampStart short-circuits an unrotated ramp
+      INDEX startIdx = size > 1 ? 1 + (INDEX) r * (size - 1) / rotations : 0;
+      GenerateRamp(container, size, startIdx, false);
+
+      INDEX rec_idx, brl_idx;
+      double rec_ns = TimeEngine(container, size, ENGINE_RECURSIVE, reps, &rec_idx);
+      double brl_ns = TimeEngine(container, size, ENGINE_BRANCHLESS, reps, &brl_idx);
+      if (rec_idx != brl_idx || brl_idx != startIdx % size) {
+        std::cout << "MISMATCH size " << size << " start " << startIdx <<
+          " recursive " << rec_idx << " branchless " << brl_idx << std::endl;
+        mismatches++;
+      }
+
+      rec_sum += rec_ns;
+      rec_min = rec_ns < rec_min ? rec_ns : rec_min;
+      rec_max = rec_ns > rec_max ? rec_ns : rec_max;
+      brl_sum += brl_ns;
+      brl_min = brl_ns < brl_min ? brl_ns : brl_min;
+      brl_max = brl_ns > brl_max ? brl_ns : brl_max;
+    }
+    FreeContainer(container);
+
+    printf("%10ld %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %8.2f\n",
+        size, rec_sum / rotations, rec_min, rec_max,
+        brl_sum / rotations, brl_min, brl_max, rec_sum / brl_sum);
+    fflush(stdout);
+  }
+
+  if (mismatches) {
+    std::cout << "ENGINE MISMATCHES: " << mismatches << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchSimd
+// Compare the branchless engine against the hybrid engine with each
+// final-stage scan implementation the CPU supports.
+// Exit: 0 on success, nonzero if the engines disagree
+static int BenchSimd(int argc, char *argv[])
+{
+  const UINT LOOKUPS_PER_SIZE = 1 << 16;
+  const UINT MAX_ROTATIONS = 8;
+  const char *isa_names[] = { "scalar", "avx2", "avx512" };
+  ScanIsa best = DetectScanIsa();
+  UINT mismatches = 0;
+
+  std::cout << "Widest scan: " << isa_names[ best ] << std::endl;
+  printf("%10s %10s %10s %10s %10s %8s\n",
+      "size", "brl_ns", "scalar_ns", "avx2_ns", "avx512_ns", "speedup");
+  for (SIZE size = 1; size <= BENCH_MAX_SIZE; size = NextBenchSize(size)) {
+    CONTAINER *container = AllocContainer(size);
+    UINT rotations = (UINT) size < MAX_ROTATIONS ? size : MAX_ROTATIONS;
+    UINT reps = LOOKUPS_PER_SIZE / rotations;
+    double brl_sum = 0.0;
+    double isa_sum[ SCAN_AVX512 + 1 ] = { 0.0, 0.0, 0.0 };
+
+    for (UINT r = 0; r < rotations; r++) {
+      INDEX startIdx = size > 1 ? 1 + (INDEX) r * (size - 1) / rotations : 0;
+      GenerateRamp(container, size, startIdx, false);
+
+      INDEX brl_idx, idx;
+      brl_sum += TimeEngine(container, size, ENGINE_BRANCHLESS, reps, &brl_idx);
+      for (int isa = SCAN_SCALAR; isa <= best; isa++) {
+        SetScanIsa((ScanIsa) isa);
+        isa_sum[ isa ] += TimeEngine(container, size, ENGINE_HYBRID, reps, &idx);
+        if (idx != brl_idx) {
+          std::cout << "MISMATCH size " << size << " start " << startIdx <<
+            " " << isa_names[ isa ] << " " << idx << " branchless " << brl_idx << std::endl;
+          mismatches++;
+        }
+      }
+      SetScanIsa(best);
+    }
+    FreeContainer(container);
+
+    printf("%10ld %10.1f", size, brl_sum / rotations);
+    for (int isa = SCAN_SCALAR; isa <= SCAN_AVX512; isa++) {
+      if (isa <= best)
+        printf(" %10.1f", isa_sum[ isa ] / rotations);
+      else
+        printf(" %10s", "-");
+    }
+    printf(" %8.2f\n", brl_sum / isa_sum[ best ]);
+    fflush(stdout);
+  }
+
+  if (mismatches) {
+    std::cout << "SCAN MISMATCHES: " << mismatches << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchBatch
+// Compare one-at-a-time branchless lookups against the batch API on a
+// pool of ramps larger than the last-level cache.  Caches are flushed
+// before every timed pass.
+// Entry: optional pool size in megabytes (default 256)
+// Exit: 0 on success, nonzero if a start is wrong
+static int BenchBatch(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 1024, 16384, 262144, 4194304 };
+  size_t pool_bytes = BenchPoolMb(argc, argv, 256) << 20;
+  UINT errors = 0;
+
+  printf("%10s %10s %10s %10s %8s\n", "size", "ramps", "seq_ns", "batch_ns", "speedup");
+  for (SIZE size : sizes) {
+    UINT count = (UINT) (pool_bytes / (size * sizeof(CONTAINER)));
+    if (!count)
+      continue;
+    RampPool pool;
+    BuildRampPool(size, count, &pool);
+    std::vector<INDEX> starts(count);
+
+    EvictCaches(pool_bytes);
+    double start = NowNs();
+    for (UINT i = 0; i < count; i++) {
+      UINT tries = 0;
+      starts[ i ] = FindRampStart(pool.containers[ i ], size, &tries, ENGINE_BRANCHLESS);
+    }
+    double seq_ns = (NowNs() - start) / count;
+    errors += starts != pool.expected;
+
+    EvictCaches(pool_bytes);
+    start = NowNs();
+    FindRampStartBatch(pool.ramps.data(), count, starts.data());
+    double batch_ns = (NowNs() - start) / count;
+    errors += starts != pool.expected;
+
+    printf("%10ld %10u %10.1f %10.1f %8.2f\n", size, count, seq_ns, batch_ns, seq_ns / batch_ns);
+    fflush(stdout);
+    FreeRampPool(&pool);
+  }
+
+  if (errors) {
+    std::cout << "BATCH ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchCoro
+// Compare the sequential loop used by main() against the lock-step batch
+// and the coroutine scheduler on a pool of ramps whose sizes vary
+// log-uniformly from 16 to 512K elements.  The pool is larger than the
+// last-level cache and caches are flushed before every timed pass.
+// Entry: optional pool size in megabytes (default 256)
+// Exit: 0 on success, nonzero if a start is wrong
+static int BenchCoro(int argc, char *argv[])
+{
+  const UINT MIN_LOG2 = 4, MAX_LOG2 = 18;
+  const UINT widths[] = { 4, 8, 16, 32, 64 };
+  size_t pool_bytes = BenchPoolMb(argc, argv, 256) << 20;
+  UINT errors = 0;
+
+  // Build the heterogeneous pool
+  RampPool pool;
+  size_t bytes = 0;
+  while (bytes < pool_bytes) {
+    UINT log2 = MIN_LOG2 + rand() % (MAX_LOG2 - MIN_LOG2 + 1);
+    SIZE size = (SIZE) ((1u << log2) + rand() % (1u << log2));
+    BuildRampPool(size, 1, &pool);
+    bytes += size * sizeof(CONTAINER);
+  }
+  UINT count = (UINT) pool.ramps.size();
+  std::vector<INDEX> starts(count);
+  std::cout << "Pool: " << count << " ramps, " << (bytes >> 20) << " MB" << std::endl;
+  printf("%-14s %10s %8s\n", "method", "ns/lookup", "speedup");
+
+  // Sequential loop as in main()
+  double seq_ns[ 2 ];
+  const PivotEngine engines[] = { ENGINE_RECURSIVE, ENGINE_BRANCHLESS };
+  for (UINT e = 0; e < 2; e++) {
+    EvictCaches(pool_bytes);
+    double start = NowNs();
+    for (UINT i = 0; i < count; i++) {
+      UINT tries = 0;
+      starts[ i ] = FindRampStart(pool.containers[ i ], pool.ramps[ i ].size, &tries, engines[ e ]);
+    }
+    seq_ns[ e ] = (NowNs() - start) / count;
+    errors += starts != pool.expected;
+  }
+  printf("%-14s %10.1f %8.2f\n", "seq recursive", seq_ns[ 0 ], 1.0);
+  printf("%-14s %10.1f %8.2f\n", "seq branchless", seq_ns[ 1 ], seq_ns[ 0 ] / seq_ns[ 1 ]);
+
+  EvictCaches(pool_bytes);
+  double start = NowNs();
+  FindRampStartBatch(pool.ramps.data(), count, starts.data());
+  double batch_ns = (NowNs() - start) / count;
+  errors += starts != pool.expected;
+  printf("%-14s %10.1f %8.2f\n", "batch", batch_ns, seq_ns[ 0 ] / batch_ns);
+
+  for (UINT width : widths) {
+    EvictCaches(pool_bytes);
+    start = NowNs();
+    FindRampStartInterleaved(pool.ramps.data(), count, starts.data(), nullptr, width);
+    double coro_ns = (NowNs() - start) / count;
+    errors += starts != pool.expected;
+    char label[ 32 ];
+    snprintf(label, sizeof(label), "coro w=%u", width);
+    printf("%-14s %10.1f %8.2f\n", label, coro_ns, seq_ns[ 0 ] / coro_ns);
+  }
+  FreeRampPool(&pool);
+
+  if (errors) {
+    std::cout << "CORO ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchDupes
+// Time the skip from the first element of the top plateau to the ramp
+// start, linear walk against galloping, while sweeping the probability
+// that an element repeats its predecessor.  Plateaus that straddle the
+// end of the buffer fall back to the linear walk and are counted.
+// Entry: optional container size (default 1M)
+// Exit: 0 on success, nonzero if the two disagree
+static int BenchDupes(int argc, char *argv[])
+{
+  const double densities[] = { 0.0, 0.5, 0.9, 0.99, 0.999, 0.9999, 0.99999 };
+  const UINT ROTATIONS = 64;
+  SIZE size = argc > 0 ? (SIZE) strtol(argv[ 0 ], nullptr, 10) : 1 << 20;
+  if (size < 2 || size > BENCH_MAX_SIZE)
+    size = 1 << 20;
+  CONTAINER *container = AllocContainer(size);
+  UINT errors = 0;
+
+  printf("%10s %10s %10s %10s %10s %8s\n",
+      "density", "avg_run", "straddles", "linear_ns", "gallop_ns", "speedup");
+  for (double density : densities) {
+    double run_sum = 0.0, linear_sum = 0.0, gallop_sum = 0.0;
+    UINT straddles = 0;
+    for (UINT r = 0; r < ROTATIONS; r++) {
+      INDEX startIdx = rand() % size;
+      GeneratePlateauRamp(container, size, startIdx, density);
+
+      // Back up from the element before the start to the top plateau's first element
+      INDEX top = (startIdx + size - 1) % size;
+      INDEX run = 1;
+      while (run < (INDEX) size && container[ (top + size - 1) % size ] == container[ top ]) {
+        top = (top + size - 1) % size;
+        run++;
+      }
+      run_sum += run;
+      straddles += container[ 0 ] == container[ top ] && container[ size - 1 ] == container[ top ];
+
+      UINT reps = (UINT) (1 + (1 << 16) / run);
+      INDEX linear_end = 0, gallop_end = 0;
+      double start = NowNs();
+      for (UINT i = 0; i < reps; i++)
+        bench_sink = linear_end = FindRunEndLinear(container, size, top);
+      linear_sum += (NowNs() - start) / reps;
+      start = NowNs();
+      for (UINT i = 0; i < reps; i++)
+        bench_sink = gallop_end = FindRunEnd(container, size, top);
+      gallop_sum += (NowNs() - start) / reps;
+      errors += linear_end != gallop_end;
+      // A ramp that is one plateau has no distinguishable start
+      errors += run < (INDEX) size && (gallop_end + 1) % size != startIdx % size;
+    }
+    printf("%10g %10.1f %10u %10.1f %10.1f %8.2f\n", density, run_sum / ROTATIONS,
+        straddles, linear_sum / ROTATIONS, gallop_sum / ROTATIONS, linear_sum / gallop_sum);
+    fflush(stdout);
+  }
+  FreeContainer(container);
+
+  if (errors) {
+    std::cout << "RUN END ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchPlateau
+// Time every engine on ramps with duplicates and count wrong answers (a
+// start whose value is not 0, the check main() applies).  The first row
+// of each size uses the dupes path of GenerateRamp; the rest use
+// GeneratePlateauRamp at increasing repeat probability.
+// Exit: 0 on success, nonzero if the plateau engine is ever wrong
+static int BenchPlateau(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 1000, 1000000 };
+  const double densities[] = { -1.0, 0.9, 0.99, 0.999, 0.9999 };
+  const PivotEngine engines[] = { ENGINE_RECURSIVE, ENGINE_BRANCHLESS, ENGINE_HYBRID, ENGINE_PLATEAU };
+  const UINT ENGINE_TOT = sizeof(engines) / sizeof(engines[ 0 ]);
+  const UINT ROTATIONS = 256;
+  UINT plateau_errors = 0;
+
+  printf("%10s %10s %16s %16s %16s %16s\n", "size", "density",
+      "recursive", "branchless", "hybrid", "plateau");
+  printf("%21s %16s %16s %16s %16s\n", "", "ns/wrong", "ns/wrong", "ns/wrong", "ns/wrong");
+  for (SIZE size : sizes) {
+    CONTAINER *container = AllocContainer(size);
+    for (double density : densities) {
+      double ns[ ENGINE_TOT ] = { 0.0 };
+      UINT wrong[ ENGINE_TOT ] = { 0 };
+      for (UINT r = 0; r < ROTATIONS; r++) {
+        INDEX startIdx = rand() % size;
+        if (density < 0.0)
+          GenerateRamp(container, size, startIdx, true);
+        else
+          GeneratePlateauRamp(container, size, startIdx, density);
+        for (UINT e = 0; e < ENGINE_TOT; e++) {
+          INDEX idx;
+          ns[ e ] += TimeEngine(container, size, engines[ e ], 64, &idx);
+          wrong[ e ] += (INDEX) ~0 == idx || container[ idx ];
+        }
+      }
+      char label[ 16 ];
+      if (density < 0.0)
+        snprintf(label, sizeof(label), "GenerateRamp");
+      else
+        snprintf(label, sizeof(label), "%g", density);
+      printf("%10ld %10s", size, label);
+      for (UINT e = 0; e < ENGINE_TOT; e++)
+        printf(" %10.1f/%5u", ns[ e ] / ROTATIONS, wrong[ e ]);
+      printf("\n");
+      fflush(stdout);
+      plateau_errors += wrong[ ENGINE_TOT - 1 ];
+    }
+    FreeContainer(container);
+  }
+
+  if (plateau_errors) {
+    std::cout << "PLATEAU ENGINE ERRORS: " << plateau_errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchStamp
+// A custom key: seconds and nanoseconds ordered lexicographically
+struct BenchStamp {
+  uint32_t sec;
+  uint32_t nsec;
+};
+
+struct BenchStampLess {
+  bool operator()(const BenchStamp &a, const BenchStamp &b) const
+  {
+    return a.sec < b.sec || (a.sec == b.sec && a.nsec < b.nsec);
+  }
+};
+
+// ToKey
+// Map a CONTAINER ramp value to an order-preserving key of another type
+template <typename T>
+static T ToKey(CONTAINER value)
+{
+  if (std::is_signed<T>::value)
+    return (T) ((int64_t) value - (1 << 30));
+  return (T) value;
+}
+
+template <>
+BenchStamp ToKey<BenchStamp>(CONTAINER value)
+{
+  return { value / 1000, (value % 1000) * 1000000 };
+}
+
+// TimeGeneric
+// Time ramp::FindStart on a copy of a ramp converted to another key type
+// Entry: pointer to CONTAINER ramp
+//        size of ramp
+//        expected ramp start
+//        number of lookups
+//        pointer to error count
+// Exit: nanoseconds per lookup
+template <typename T, typename Compare = std::less<T>>
+static double TimeGeneric(
+    const CONTAINER *container,
+    SIZE size,
+    INDEX expected,
+    UINT reps,
+    UINT *errors)
+{
+  std::vector<T> keys(size);
+  for (SIZE i = 0; i < size; i++)
+    keys[ i ] = ToKey<T>(container[ i ]);
+
+  INDEX idx = 0;
+  double start = NowNs();
+  for (UINT i = 0; i < reps; i++) {
+    idx = ramp::FindStart(keys.data(), (INDEX) size, Compare());
+    bench_sink = idx;
+  }
+  double ns = (NowNs() - start) / reps;
+  *errors += idx != expected;
+  return ns;
+}
+
+// BenchGeneric
+// Time the template library on each key type against the CONTAINER
+// engines.  uint16 keys are skipped once the ramp no longer fits in them.
+// Exit: 0 on success, nonzero if any start is wrong
+static int BenchGeneric(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 1000, 60000, 1000000, BENCH_MAX_SIZE };
+  const UINT ROTATIONS = 8;
+  const UINT REPS = 1 << 14;
+  const UINT COLUMNS = 8;
+  UINT errors = 0;
+
+  printf("%10s %8s %8s %8s %8s %8s %8s %8s %8s\n", "size", "c_rec", "c_brl",
+      "u16", "u32", "u64", "i64", "double", "stamp");
+  for (SIZE size : sizes) {
+    CONTAINER *container = AllocContainer(size);
+    double ns[ COLUMNS ] = { 0.0 };
+    for (UINT r = 0; r < ROTATIONS; r++) {
+      INDEX startIdx = 1 + rand() % (size - 1);
+      GenerateRamp(container, size, startIdx, false);
+      INDEX idx;
+      ns[ 0 ] += TimeEngine(container, size, ENGINE_RECURSIVE, REPS, &idx);
+      ns[ 1 ] += TimeEngine(container, size, ENGINE_BRANCHLESS, REPS, &idx);
+      errors += idx != startIdx;
+      if (size <= 65536)
+        ns[ 2 ] += TimeGeneric<uint16_t>(container, size, startIdx, REPS, &errors);
+      ns[ 3 ] += TimeGeneric<uint32_t>(container, size, startIdx, REPS, &errors);
+      ns[ 4 ] += TimeGeneric<uint64_t>(container, size, startIdx, REPS, &errors);
+      ns[ 5 ] += TimeGeneric<int64_t>(container, size, startIdx, REPS, &errors);
+      ns[ 6 ] += TimeGeneric<double>(container, size, startIdx, REPS, &errors);
+      ns[ 7 ] += TimeGeneric<BenchStamp, BenchStampLess>(container, size, startIdx, REPS, &errors);
+    }
+    FreeContainer(container);
+
+    printf("%10ld", size);
+    for (UINT c = 0; c < COLUMNS; c++) {
+      if (c == 2 && size > 65536)
+        printf(" %8s", "-");
+      else
+        printf(" %8.1f", ns[ c ] / ROTATIONS);
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  if (errors) {
+    std::cout << "GENERIC ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchKeys
+// Compare three ways of finding a key's lower bound in a rotated ramp:
+// FindStart followed by ramp::LowerBound, the single-pass
+// ramp::LowerBoundSinglePass, and unrotating with std::rotate followed by
+// std::lower_bound.  The rotated copy is restored between queries outside
+// the timed region.
+// Exit: 0 on success, nonzero if the methods disagree
+static int BenchKeys(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 1000, 100000, 1000000, BENCH_MAX_SIZE };
+  const UINT QUERIES = 256;
+  const UINT ROTATE_QUERIES = 16;
+  UINT errors = 0;
+
+  printf("%10s %12s %12s %12s %10s\n", "size", "pivot+lb_ns", "single_ns", "rotate_ns", "speedup");
+  for (SIZE size : sizes) {
+    CONTAINER *container = AllocContainer(size);
+    INDEX startIdx = 1 + rand() % (size - 1);
+    GenerateRamp(container, size, startIdx, false);
+    std::vector<CONTAINER> keys(QUERIES);
+    std::vector<INDEX> expected(QUERIES);
+    for (UINT q = 0; q < QUERIES; q++) {
+      // Include keys above the largest element
+      keys[ q ] = rand() % (size + size / 16 + 1);
+      expected[ q ] = keys[ q ] < (INDEX) size ? (startIdx + keys[ q ]) % size : size;
+    }
+
+    // Pivot search plus one binary search
+    double start = NowNs();
+    for (UINT q = 0; q < QUERIES; q++) {
+      INDEX ramp_start = ramp::FindStart(container, (INDEX) size);
+      INDEX offset = ramp::LowerBound(container, (INDEX) size, ramp_start, keys[ q ]);
+      INDEX idx = offset < (INDEX) size ? ramp::ToPhysical(ramp_start, offset, (INDEX) size) : size;
+      errors += idx != expected[ q ];
+      bench_sink = idx;
+    }
+    double pivot_ns = (NowNs() - start) / QUERIES;
+
+    // Single pass
+    start = NowNs();
+    for (UINT q = 0; q < QUERIES; q++) {
+      INDEX idx = ramp::LowerBoundSinglePass(container, (INDEX) size, keys[ q ]);
+      errors += idx != expected[ q ];
+      bench_sink = idx;
+    }
+    double single_ns = (NowNs() - start) / QUERIES;
+
+    // Unrotate, then search the sorted copy
+    std::vector<CONTAINER> work(size);
+    double rotate_ns = 0.0;
+    for (UINT q = 0; q < ROTATE_QUERIES; q++) {
+      std::copy(container, container + size, work.begin());
+      start = NowNs();
+      std::rotate(work.begin(), work.begin() + startIdx, work.end());
+      INDEX offset = (INDEX) (std::lower_bound(work.begin(), work.end(), keys[ q ]) - work.begin());
+      rotate_ns += NowNs() - start;
+      INDEX idx = offset < (INDEX) size ? (startIdx + offset) % size : size;
+      errors += idx != expected[ q ];
+    }
+    rotate_ns /= ROTATE_QUERIES;
+    FreeContainer(container);
+
+    printf("%10ld %12.1f %12.1f %12.1f %10.0f\n", size, pivot_ns, single_ns, rotate_ns,
+        rotate_ns / (pivot_ns < single_ns ? pivot_ns : single_ns));
+    fflush(stdout);
+  }
+
+  // Equal ranges on a ramp with duplicates
+  const SIZE size = 100000;
+  CONTAINER *container = AllocContainer(size);
+  INDEX startIdx = 1 + rand() % (size - 1);
+  GenerateRamp(container, size, startIdx, true);
+  INDEX ramp_start = ramp::FindStartDuplicates(container, (INDEX) size);
+  for (UINT q = 0; q < QUERIES; q++) {
+    CONTAINER key = container[ rand() % size ];
+    std::pair<INDEX, INDEX> range = ramp::EqualRange(container, (INDEX) size, ramp_start, key);
+    INDEX count = 0;
+    for (SIZE i = 0; i < size; i++)
+      count += container[ i ] == key;
+    errors += range.second - range.first != count;
+    errors += container[ ramp::ToPhysical(ramp_start, range.first, (INDEX) size) ] != key;
+  }
+  FreeContainer(container);
+
+  if (errors) {
+    std::cout << "KEY SEARCH ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchDense
+// Compare the dense closed-form engine with bisection on dense ramps, and
+// show its fallback cost on ramps with duplicates, which fail the check.
+// Tries are the mean per lookup.
+// Exit: 0 on success, nonzero if a dense lookup is wrong
+static int BenchDense(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 100, 10000, 1000000, BENCH_MAX_SIZE };
+  const PivotEngine engines[] = { ENGINE_RECURSIVE, ENGINE_BRANCHLESS, ENGINE_DENSE };
+  const UINT ENGINE_TOT = sizeof(engines) / sizeof(engines[ 0 ]);
+  const UINT ROTATIONS = 64;
+  const UINT REPS = 256;
+  UINT errors = 0;
+
+  printf("%10s %6s %14s %14s %14s\n", "size", "dupes", "recursive", "branchless", "dense");
+  printf("%17s %14s %14s %14s\n", "", "ns/tries", "ns/tries", "ns/tries");
+  for (SIZE size : sizes) {
+    CONTAINER *container = AllocContainer(size);
+    for (bool dupes : { false, true }) {
+      double ns[ ENGINE_TOT ] = { 0.0 };
+      double tries[ ENGINE_TOT ] = { 0.0 };
+      for (UINT r = 0; r < ROTATIONS; r++) {
+        INDEX startIdx = 1 + rand() % (size - 1);
+        GenerateRamp(container, size, startIdx, dupes);
+        for (UINT e = 0; e < ENGINE_TOT; e++) {
+          INDEX idx;
+          UINT count = 0;
+          ns[ e ] += TimeEngine(container, size, engines[ e ], REPS, &idx);
+          FindRampStart(container, size, &count, engines[ e ]);
+          tries[ e ] += count;
+          errors += engines[ e ] == ENGINE_DENSE && container[ idx ];
+        }
+      }
+      printf("%10ld %6s", size, dupes ? "yes" : "no");
+      for (UINT e = 0; e < ENGINE_TOT; e++)
+        printf(" %8.1f/%5.1f", ns[ e ] / ROTATIONS, tries[ e ] / ROTATIONS);
+      printf("\n");
+      fflush(stdout);
+    }
+    FreeContainer(container);
+  }
+
+  if (errors) {
+    std::cout << "DENSE ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// Distribution
+// Strictly increasing value at logical rank r of a ramp of size n
+enum Distribution {
+  DIST_LINEAR,          // r
+  DIST_STEPS,           // random steps of 1..7
+  DIST_QUADRATIC,       // r + r^2 / n
+  DIST_EXPONENTIAL,     // r + 100 (e^(10 r / n) - 1)
+  DIST_TWO_SLOPE,       // slope 1 for the first half, 16 after
+  DIST_TOT
+};
+
+// GenerateDistRamp
+// Fill a container with a ramp of the given distribution starting at startIdx
+// Entry: pointer to container
+//        size of container
+//        start index in container
+//        distribution
+static void GenerateDistRamp(CONTAINER *container, SIZE size, INDEX startIdx, Distribution dist)
+{
+  double n = size;
+  CONTAINER value = 0;
+  for (SIZE r = 0; r < size; r++) {
+    switch (dist) {
+      case DIST_LINEAR:
+        value = r;
+        break;
+      case DIST_STEPS:
+        value = r ? value + 1 + rand() % 7 : 0;
+        break;
+      case DIST_QUADRATIC:
+        value = r + (CONTAINER) ((double) r * r / n);
+        break;
+      case DIST_EXPONENTIAL:
+        value = r + (CONTAINER) (100.0 * (exp(10.0 * r / n) - 1.0));
+        break;
+      case DIST_TWO_SLOPE:
+      default:
+        value = r < size / 2 ? r : size / 2 + (r - size / 2) * 16;
+        break;
+    }
+    container[ (startIdx + r) % size ] = value;
+  }
+}
+
+// BenchPredict
+// Compare plain bisection with the interpolation predictor and a fitted
+// RampModel across value distributions.  The model is fitted once on the
+// first rotation and reused for the others, which hold the same values.
+// Tries are reported as mean and worst case per lookup.
+// Entry: optional container size (default 1M)
+// Exit: 0 on success, nonzero if a pivot is wrong
+static int BenchPredict(int argc, char *argv[])
+{
+  const char *dist_names[] = { "linear", "steps", "quadratic", "exponential", "two-slope" };
+  const UINT ROTATIONS = 256;
+  const UINT REPS = 64;
+  SIZE size = argc > 0 ? (SIZE) strtol(argv[ 0 ], nullptr, 10) : 1000000;
+  if (size < 16 || size > BENCH_MAX_SIZE)
+    size = 1000000;
+  const INDEX window = size / 256 + 16;
+  CONTAINER *container = AllocContainer(size);
+  std::vector<CONTAINER> master(size);
+  UINT errors = 0;
+
+  std::cout << "Size " << size << ", interpolation window +/-" << window << std::endl;
+  printf("%12s %20s %20s %20s %8s\n", "", "bisection", "interpolation", "model", "model");
+  printf("%12s %20s %20s %20s %8s\n", "distribution", "ns/mean/worst", "ns/mean/worst",
+      "ns/mean/worst", "error");
+  for (UINT d = 0; d < DIST_TOT; d++) {
+    GenerateDistRamp(master.data(), size, 0, (Distribution) d);
+    ramp::RampModel<CONTAINER, INDEX> model;
+    double ns[ 3 ] = { 0.0 }, mean[ 3 ] = { 0.0 }, worst[ 3 ] = { 0.0 };
+
+    for (UINT r = 0; r < ROTATIONS; r++) {
+      INDEX startIdx = 1 + rand() % (size - 1);
+      std::rotate_copy(master.begin(), master.begin() + (size - startIdx), master.end(), container);
+      if (!r)
+        model.Fit(container, (INDEX) size, startIdx);
+      INDEX expected = startIdx - 1;
+
+      for (UINT m = 0; m < 3; m++) {
+        INDEX pivot = 0;
+        double start = NowNs();
+        for (UINT i = 0; i < REPS; i++) {
+          if (m == 0)
+            pivot = ramp::FindPivot(container, (INDEX) size);
+          else if (m == 1)
+            pivot = ramp::FindPivotInterpolated(container, (INDEX) size, (CONTAINER) 0, window);
+          else
+            pivot = model.FindPivot(container);
+          bench_sink = pivot;
+        }
+        ns[ m ] += (NowNs() - start) / REPS;
+        errors += pivot != expected;
+
+        INDEX tries = 0;
+        if (m == 0)
+          ramp::FindPivot(container, (INDEX) size, std::less<CONTAINER>(), &tries);
+        else if (m == 1)
+          ramp::FindPivotInterpolated(container, (INDEX) size, (CONTAINER) 0, window, &tries);
+        else
+          model.FindPivot(container, &tries);
+        mean[ m ] += tries;
+        worst[ m ] = tries > worst[ m ] ? tries : worst[ m ];
+      }
+    }
+
+    printf("%12s", dist_names[ d ]);
+    for (UINT m = 0; m < 3; m++)
+      printf(" %8.1f/%5.1f/%5.0f", ns[ m ] / ROTATIONS, mean[ m ] / ROTATIONS, worst[ m ]);
+    printf(" %8lu\n", model.Error());
+    fflush(stdout);
+  }
+  FreeContainer(container);
+
+  if (errors) {
+    std::cout << "PREDICT ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchHint
+// Replay a ring buffer that is written in place, each lookup following k
+// pushes that overwrite the oldest entries, and compare a cold branchless
+// search with one galloping from the previous start.  Tries are the mean
+// per lookup.
+// Entry: optional container size (default 1M)
+// Exit: 0 on success, nonzero if a hinted lookup is wrong
+static int BenchHint(int argc, char *argv[])
+{
+  const UINT REPS = 16;
+  const UINT MAX_PUSHES = 1 << 26;
+  SIZE size = argc > 0 ? (SIZE) strtol(argv[ 0 ], nullptr, 10) : 1000000;
+  if (size < 16 || size > BENCH_MAX_SIZE)
+    size = 1000000;
+  const UINT advances[] = { 1, 4, 16, 256, 4096, 65536, (UINT) size / 2 };
+  CONTAINER *container = AllocContainer(size);
+  UINT errors = 0;
+
+  std::cout << "Size " << size << std::endl;
+  printf("%10s %8s %14s %14s\n", "advance", "lookups", "cold", "hint");
+  printf("%10s %8s %14s %14s\n", "", "", "ns/tries", "ns/tries");
+  for (UINT k : advances) {
+    if (k >= (UINT) size)
+      continue;
+    GenerateRamp(container, size, 0, false);
+    INDEX head = 0;
+    CONTAINER next = size;
+    UINT lookups = std::min<UINT>(4096, MAX_PUSHES / k);
+    double ns[ 2 ] = { 0.0 }, tries[ 2 ] = { 0.0 };
+
+    for (UINT l = 0; l < lookups; l++) {
+      // Overwrite the k oldest entries with the next k values
+      INDEX prev = head;
+      for (UINT i = 0; i < k; i++) {
+        container[ head ] = next++;
+        head = head + 1 == (INDEX) size ? 0 : head + 1;
+      }
+
+      INDEX idx = 0;
+      UINT count = 0;
+      double start = NowNs();
+      for (UINT i = 0; i < REPS; i++) {
+        idx = FindRampStart(container, size, &count, ENGINE_BRANCHLESS);
+        bench_sink = idx;
+      }
+      ns[ 0 ] += (NowNs() - start) / REPS;
+      tries[ 0 ] += (double) count / REPS;
+      errors += idx != head;
+
+      count = 0;
+      start = NowNs();
+      for (UINT i = 0; i < REPS; i++) {
+        idx = FindRampStartFromHint(container, size, prev, &count);
+        bench_sink = idx;
+      }
+      ns[ 1 ] += (NowNs() - start) / REPS;
+      tries[ 1 ] += (double) count / REPS;
+      errors += idx != head;
+    }
+
+    printf("%10u %8u", k, lookups);
+    for (UINT m = 0; m < 2; m++)
+      printf(" %8.1f/%5.1f", ns[ m ] / lookups, tries[ m ] / lookups);
+    printf("\n");
+    fflush(stdout);
+  }
+  FreeContainer(container);
+
+  if (errors) {
+    std::cout << "HINT ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchRing
+// Push values through a full RotatedRamp, reading the start after every
+// push from the tracked head and, for comparison, from a cold search of
+// the same buffer.  Then overwrite the buffer with rotated ramps that do
+// not start from 0 and check Recover() against the known start.
+// Entry: optional capacity (default 1M)
+// Exit: 0 on success, nonzero if a start is wrong
+static int BenchRing(int argc, char *argv[])
+{
+  const UINT PUSHES = 1 << 24;
+  const UINT SEARCHES = 1 << 18;
+  const UINT RECOVERIES = 256;
+  SIZE size = argc > 0 ? (SIZE) strtol(argv[ 0 ], nullptr, 10) : 1000000;
+  if (size < 16 || size > BENCH_MAX_SIZE)
+    size = 1000000;
+  RotatedRamp ring(size);
+  CONTAINER next = 0;
+  UINT errors = 0;
+
+  while (!ring.Full())
+    ring.Push(next++);
+
+  std::cout << "Capacity " << size << std::endl;
+  printf("%-22s %10s %12s\n", "method", "ns/push", "Mpushes/s");
+
+  double start = NowNs();
+  for (UINT i = 0; i < PUSHES; i++) {
+    ring.Push(next++);
+    bench_sink = ring.Start();
+  }
+  double ns = (NowNs() - start) / PUSHES;
+  printf("%-22s %10.2f %12.1f\n", "push + Start()", ns, 1e3 / ns);
+  errors += ring.Front() != next - size;
+
+  start = NowNs();
+  for (UINT i = 0; i < SEARCHES; i++) {
+    ring.Push(next++);
+    UINT tries = 0;
+    INDEX idx = FindRampStart(ring.Data(), size, &tries, ENGINE_BRANCHLESS);
+    errors += idx != ring.Start();
+    bench_sink = idx;
+  }
+  ns = (NowNs() - start) / SEARCHES;
+  printf("%-22s %10.2f %12.1f\n", "push + cold search", ns, 1e3 / ns);
+
+  // Bulk loads from a nonzero base, with and without duplicates
+  double tries = 0.0;
+  for (UINT r = 0; r < RECOVERIES; r++) {
+    bool dupes = r & 1;
+    INDEX startIdx = rand() % size;
+    CONTAINER base = 1 + rand() % 1000;
+    GenerateRamp(ring.Data(), size, startIdx, dupes);
+    for (SIZE i = 0; i < size; i++)
+      ring.Data()[ i ] += base;
+    UINT count = 0;
+    INDEX idx = ring.Recover(dupes, &count);
+    tries += count;
+    errors += ring.Data()[ idx ] != base || (idx != startIdx && ring.Data()[ idx ? idx - 1 : size - 1 ] == base);
+    ring.Push(ring.Back());
+    errors += ring.Start() != (idx + 1) % (INDEX) size;
+  }
+  printf("Recover: %.1f tries mean over %u bulk loads\n", tries / RECOVERIES, RECOVERIES);
+
+  if (errors) {
+    std::cout << "RING ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchKary
+// Compare binary branchless bisection with the k-ary search for k = 4, 8
+// and 16 on working sets sized for L2, L3 and DRAM.  Each working set is
+// a pool of equal ramps, looked up in random order one at a time, so
+// every level of a search is a dependent load.  Tries are the mean per
+// lookup.
+// Entry: optional DRAM working set in megabytes (default 1024)
+// Exit: 0 on success, nonzero if a pivot is wrong
+static int BenchKary(int argc, char *argv[])
+{
+  struct Tier {
+    const char *name;
+    SIZE size;
+    size_t bytes;
+  };
+  const Tier tiers[] = {
+    { "L2", 65536, (size_t) 1 << 20 },
+    { "L3", 1048576, (size_t) 64 << 20 },
+    { "DRAM", 4194304, BenchPoolMb(argc, argv, 1024) << 20 },
+  };
+  const UINT ways[] = { 0, 4, 8, 16 };      // 0 is binary bisection
+  const UINT WAYS_TOT = sizeof(ways) / sizeof(ways[ 0 ]);
+  const UINT LOOKUPS = 1 << 18;
+  UINT errors = 0;
+
+  printf("%6s %10s %6s %14s %14s %14s %14s\n", "tier", "size", "ramps", "binary", "k=4", "k=8", "k=16");
+  printf("%25s %14s %14s %14s %14s\n", "", "ns/tries", "ns/tries", "ns/tries", "ns/tries");
+  for (const Tier &tier : tiers) {
+    UINT count = (UINT) (tier.bytes / (tier.size * sizeof(CONTAINER)));
+    count = count ? count : 1;
+    RampPool pool;
+    BuildRampPool(tier.size, count, &pool);
+    std::vector<UINT> order(LOOKUPS);
+    for (UINT &o : order)
+      o = rand() % count;
+
+    printf("%6s %10ld %6u", tier.name, tier.size, count);
+    for (UINT w = 0; w < WAYS_TOT; w++) {
+      UINT tries = 0;
+      double start = NowNs();
+      for (UINT i = 0; i < LOOKUPS; i++) {
+        const CONTAINER *container = pool.containers[ order[ i ] ];
+        INDEX pivot = ways[ w ] ?
+          FindRampPivotKary(container, tier.size, ways[ w ], &tries) :
+          FindRampPivotBranchless(container, tier.size, &tries);
+        INDEX expected = pool.expected[ order[ i ] ];
+        errors += pivot != (expected ? expected - 1 : (INDEX) tier.size - 1);
+        bench_sink = pivot;
+      }
+      double ns = (NowNs() - start) / LOOKUPS;
+      printf(" %8.1f/%5.1f", ns, (double) tries / LOOKUPS);
+    }
+    printf("\n");
+    fflush(stdout);
+    FreeRampPool(&pool);
+  }
+
+  if (errors) {
+    std::cout << "KARY ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchLayout
+// Build the Eytzinger and B+ tree layouts of a rotated ramp and compare
+// random-key lower bounds and pivot searches against the linear layout.
+// The crossover column is the number of key lookups after which the
+// build has paid for itself.
+// Exit: 0 on success, nonzero if a layout disagrees with the linear search
+static int BenchLayout(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 1024, 65536, 1048576, BENCH_MAX_SIZE };
+  const UINT LOOKUPS = 1 << 20;
+  const char *names[] = { "linear", "eytzinger", "btree" };
+  UINT errors = 0;
+
+  printf("%10s %-10s %10s %10s %10s %12s\n", "size", "layout", "build_ms", "key_ns", "pivot_ns", "crossover");
+  for (SIZE size : sizes) {
+    CONTAINER *container = AllocContainer(size);
+    INDEX startIdx = 1 + rand() % (size - 1);
+    GenerateRamp(container, size, startIdx, false);
+    std::vector<CONTAINER> keys(LOOKUPS);
+    for (CONTAINER &key : keys)
+      key = rand() % (size + size / 16);
+    std::vector<INDEX> expected(LOOKUPS);
+
+    ramp::EytzingerRamp<CONTAINER, INDEX> eytzinger;
+    ramp::BTreeRamp<CONTAINER, INDEX> btree;
+    double build_ms[ 3 ] = { 0.0 };
+    double start = NowNs();
+    eytzinger.Build(container, size);
+    build_ms[ 1 ] = (NowNs() - start) / 1e6;
+    start = NowNs();
+    btree.Build(container, size);
+    build_ms[ 2 ] = (NowNs() - start) / 1e6;
+
+    double key_ns[ 3 ], pivot_ns[ 3 ];
+    for (UINT m = 0; m < 3; m++) {
+      start = NowNs();
+      for (UINT i = 0; i < LOOKUPS; i++) {
+        INDEX pos;
+        if (m == 0)
+          pos = ramp::LowerBound(container, (INDEX) size, startIdx, keys[ i ]);
+        else if (m == 1)
+          pos = eytzinger.LowerBound(keys[ i ]);
+        else
+          pos = btree.LowerBound(keys[ i ]);
+        if (!m)
+          expected[ i ] = pos;
+        else
+          errors += pos != expected[ i ];
+        bench_sink = pos;
+      }
+      key_ns[ m ] = (NowNs() - start) / LOOKUPS;
+
+      INDEX pivot = 0;
+      start = NowNs();
+      for (UINT i = 0; i < LOOKUPS; i++) {
+        if (m == 0)
+          pivot = ramp::FindPivot(container, (INDEX) size);
+        else if (m == 1)
+          pivot = eytzinger.FindPivot();
+        else
+          pivot = btree.FindPivot();
+        bench_sink = pivot;
+      }
+      pivot_ns[ m ] = (NowNs() - start) / LOOKUPS;
+      errors += pivot != startIdx - 1;
+    }
+
+    // Round trip back to the linear layout
+    std::vector<CONTAINER> linear(size);
+    eytzinger.ToLinear(linear.data());
+    errors += !std::equal(linear.begin(), linear.end(), container);
+    std::fill(linear.begin(), linear.end(), 0);
+    btree.ToLinear(linear.data());
+    errors += !std::equal(linear.begin(), linear.end(), container);
+
+    for (UINT m = 0; m < 3; m++) {
+      printf("%10ld %-10s %10.2f %10.1f %10.1f", size, names[ m ], build_ms[ m ], key_ns[ m ], pivot_ns[ m ]);
+      if (m && key_ns[ m ] < key_ns[ 0 ])
+        printf(" %12.0f\n", build_ms[ m ] * 1e6 / (key_ns[ 0 ] - key_ns[ m ]));
+      else
+        printf(" %12s\n", m ? "never" : "-");
+    }
+    fflush(stdout);
+    FreeContainer(container);
+  }
+
+  if (errors) {
+    std::cout << "LAYOUT ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchSample
+// Look up pivots and random keys across a pool of large ramps, in random
+// order, with and without a SampleIndex per ramp.  The pool is larger
+// than the last-level cache; the indexes together fit in L2.  Tries count
+// probes of the containers only.
+// Entry: optional pool size in megabytes (default 512)
+// Exit: 0 on success, nonzero if an indexed search disagrees
+static int BenchSample(int argc, char *argv[])
+{
+  const SIZE size = BENCH_MAX_SIZE;
+  const UINT LOOKUPS = 1 << 18;
+  size_t pool_bytes = BenchPoolMb(argc, argv, 512) << 20;
+  UINT count = (UINT) (pool_bytes / (size * sizeof(CONTAINER)));
+  count = count ? count : 1;
+  UINT errors = 0;
+
+  RampPool pool;
+  BuildRampPool(size, count, &pool);
+  std::vector<ramp::SampleIndex<CONTAINER, INDEX>> indexes(count);
+  double start = NowNs();
+  for (UINT i = 0; i < count; i++)
+    indexes[ i ].Build(pool.containers[ i ], size);
+  double build_us = (NowNs() - start) / 1e3 / count;
+  std::vector<UINT> order(LOOKUPS);
+  std::vector<CONTAINER> keys(LOOKUPS);
+  for (UINT i = 0; i < LOOKUPS; i++) {
+    order[ i ] = rand() % count;
+    keys[ i ] = rand() % size;
+  }
+
+  std::cout << "Pool: " << count << " ramps of " << size << ", index " <<
+    indexes[ 0 ].Bytes() << " bytes each (stride " << indexes[ 0 ].Stride() <<
+    "), built in " << build_us << " us" << std::endl;
+  printf("%-8s %18s %18s\n", "", "pivot", "lower_bound");
+  printf("%-8s %18s %18s\n", "method", "ns/tries", "ns/tries");
+  for (UINT m = 0; m < 2; m++) {
+    double ns[ 2 ], tries[ 2 ];
+    for (UINT q = 0; q < 2; q++) {
+      INDEX count_tries = 0;
+      start = NowNs();
+      for (UINT i = 0; i < LOOKUPS; i++) {
+        UINT r = order[ i ];
+        const CONTAINER *container = pool.containers[ r ];
+        INDEX expected = pool.expected[ r ];
+        INDEX result;
+        if (!q) {
+          result = m ? indexes[ r ].FindStart(container, &count_tries) :
+            ramp::FindStart(container, (INDEX) size, std::less<CONTAINER>(), &count_tries);
+          errors += result != expected;
+        } else {
+          result = m ? indexes[ r ].LowerBound(container, expected, keys[ i ], &count_tries) :
+            ramp::LowerBound(container, (INDEX) size, expected, keys[ i ]);
+          errors += result != keys[ i ];
+        }
+        bench_sink = result;
+      }
+      ns[ q ] = (NowNs() - start) / LOOKUPS;
+      tries[ q ] = (double) count_tries / LOOKUPS;
+    }
+    printf("%-8s %11.1f/%5.1f %11.1f/%5.1f\n", m ? "index" : "plain", ns[ 0 ], tries[ 0 ], ns[ 1 ], tries[ 1 ]);
+  }
+
+  // Rotate one ramp in place: stale until refreshed, exact after
+  CONTAINER *container = pool.containers[ 0 ];
+  INDEX rotated = (pool.expected[ 0 ] + size / 3) % size;
+  GenerateRamp(container, size, rotated, false);
+  indexes[ 0 ].Invalidate();
+  errors += indexes[ 0 ].FindStart(container) != rotated;
+  start = NowNs();
+  indexes[ 0 ].Refresh(container);
+  double refresh_us = (NowNs() - start) / 1e3;
+  errors += indexes[ 0 ].FindStart(container) != rotated;
+  std::cout << "Refresh: " << refresh_us << " us" << std::endl;
+  FreeRampPool(&pool);
+
+  if (errors) {
+    std::cout << "SAMPLE ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchMmap
+// Write a ramp file, then find its start through a mapping with the page
+// cache dropped before every lookup.  Plain bisection with default
+// readahead and with MADV_RANDOM is compared against the page-aligned
+// search; faults and bytes read are per lookup.
+// Entry: optional file size in megabytes (default 256)
+//        optional directory for the file (default /tmp)
+// Exit: 0 on success, nonzero if a start is wrong or the file fails
+static int BenchMmap(int argc, char *argv[])
+{
+  const UINT LOOKUPS = 32;
+  const char *names[] = { "bisect/normal", "bisect/random", "paged/random" };
+  size_t mb = BenchPoolMb(argc, argv, 256);
+  SIZE size = (SIZE) ((mb << 20) / sizeof(CONTAINER));
+  std::string path = std::string(argc > 1 ? argv[ 1 ] : "/tmp") + "/findramp_bench.ramp";
+  INDEX startIdx = 1 + (((INDEX) rand() << 31) ^ (INDEX) rand()) % (size - 1);
+  UINT errors = 0;
+
+  if (!WriteRampFile(path.c_str(), size, startIdx)) {
+    std::cout << "Cannot write " << path << std::endl;
+    return -1;
+  }
+  std::cout << "File " << path << ": " << size << " elements, " << mb << " MB" << std::endl;
+  printf("%-14s %10s %10s %10s %12s\n", "method", "us", "minflt", "majflt", "read_kb");
+  for (UINT m = 0; m < 3; m++) {
+    MappedRamp ramp;
+    if (!MapRamp(path.c_str(), &ramp, m != 0)) {
+      std::cout << "Cannot map " << path << std::endl;
+      unlink(path.c_str());
+      return -1;
+    }
+    double us = 0.0;
+    PageStats total = { 0, 0, 0 };
+    for (UINT i = 0; i < LOOKUPS; i++) {
+      DropRampPages(&ramp);
+      PageStats before, after;
+      ReadPageStats(&before);
+      double start = NowNs();
+      UINT tries = 0;
+      INDEX pivot = m == 2 ?
+        FindRampPivotPaged(ramp.container, ramp.size, &tries) :
+        FindRampPivotBranchless(ramp.container, ramp.size, &tries);
+      us += (NowNs() - start) / 1e3;
+      ReadPageStats(&after);
+      total.minor_faults += after.minor_faults - before.minor_faults;
+      total.major_faults += after.major_faults - before.major_faults;
+      total.read_bytes += after.read_bytes - before.read_bytes;
+      errors += pivot != startIdx - 1;
+    }
+    printf("%-14s %10.1f %10.1f %10.1f %12.1f\n", names[ m ], us / LOOKUPS,
+        (double) total.minor_faults / LOOKUPS, (double) total.major_faults / LOOKUPS,
+        (double) total.read_bytes / 1024 / LOOKUPS);
+    fflush(stdout);
+    UnmapRamp(&ramp);
+  }
+  unlink(path.c_str());
+
+  if (errors) {
+    std::cout << "MMAP ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchUring
+// Write a ramp file and find its pivot with direct I/O, bypassing the
+// page cache: blocking pread bisection against the io_uring k-ary search
+// at several widths.  Round trips, blocks read and wall time are per
+// lookup.
+// Entry: optional file size in megabytes (default 256)
+//        optional directory for the file (default /tmp)
+// Exit: 0 on success, nonzero if a pivot is wrong or I/O fails
+static int BenchUring(int argc, char *argv[])
+{
+  const UINT LOOKUPS = 32;
+  const UINT ways[] = { 2, 4, 8, 16, 32, 64 };
+  size_t mb = BenchPoolMb(argc, argv, 256);
+  SIZE size = (SIZE) ((mb << 20) / sizeof(CONTAINER));
+  std::string path = std::string(argc > 1 ? argv[ 1 ] : "/tmp") + "/findramp_bench.ramp";
+  UINT errors = 0;
+
+  std::cout << "File " << path << ": " << size << " elements, " << mb << " MB" << std::endl;
+  printf("%-12s %10s %10s %10s\n", "method", "us", "rounds", "blocks");
+  RampFile file;
+  Uring ring;
+  INDEX startIdx = 1 + (((INDEX) rand() << 31) ^ (INDEX) rand()) % (size - 1);
+  if (!WriteRampFile(path.c_str(), size, startIdx) || !OpenRampFile(path.c_str(), &file)) {
+    std::cout << "Cannot write " << path << std::endl;
+    unlink(path.c_str());
+    return -1;
+  }
+  if (!UringInit(&ring, URING_MAX_WAYS)) {
+    std::cout << "io_uring unavailable" << std::endl;
+    CloseRampFile(&file);
+    unlink(path.c_str());
+    return -1;
+  }
+
+  UINT reads = 0;
+  double start = NowNs();
+  for (UINT i = 0; i < LOOKUPS; i++)
+    errors += FindRampPivotPread(&file, &reads) != startIdx - 1;
+  double us = (NowNs() - start) / 1e3 / LOOKUPS;
+  printf("%-12s %10.1f %10.1f %10.1f\n", "pread", us, (double) reads / LOOKUPS, (double) reads / LOOKUPS);
+
+  for (UINT w : ways) {
+    UINT rounds = 0;
+    reads = 0;
+    start = NowNs();
+    for (UINT i = 0; i < LOOKUPS; i++)
+      errors += FindRampPivotUring(&ring, &file, w, &rounds, &reads) != startIdx - 1;
+    us = (NowNs() - start) / 1e3 / LOOKUPS;
+    char label[ 32 ];
+    snprintf(label, sizeof(label), "uring k=%u", w);
+    printf("%-12s %10.1f %10.1f %10.1f\n", label, us, (double) rounds / LOOKUPS, (double) reads / LOOKUPS);
+    fflush(stdout);
+  }
+  UringExit(&ring);
+  CloseRampFile(&file);
+  unlink(path.c_str());
+
+  if (errors) {
+    std::cout << "URING ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// DropFileCache
+// Evict a file's clean pages from the page cache
+// Entry: path
+static void DropFileCache(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+// BenchSidecar
+// Write a directory of ramp files, build their sidecars with one thread
+// and with one per CPU, then simulate a cold process start that finds
+// every ramp start by searching the mapped files and by loading the
+// sidecars.  Finally one file is rewritten to check that its stale
+// sidecar is detected and rebuilt.
+// Entry: optional number of files (default 64)
+//        optional file size in megabytes (default 4)
+// Exit: 0 on success, nonzero if a start is wrong
+static int BenchSidecar(int argc, char *argv[])
+{
+  UINT files = argc > 0 && strtoul(argv[ 0 ], nullptr, 10) ? (UINT) strtoul(argv[ 0 ], nullptr, 10) : 64;
+  size_t mb = argc > 1 && strtoul(argv[ 1 ], nullptr, 10) ? strtoul(argv[ 1 ], nullptr, 10) : 4;
+  SIZE size = (SIZE) ((mb << 20) / sizeof(CONTAINER));
+  char dir[] = "/tmp/findramp_sidecar.XXXXXX";
+  UINT errors = 0;
+
+  if (!mkdtemp(dir)) {
+    std::cout << "Cannot create a directory in /tmp" << std::endl;
+    return -1;
+  }
+  std::vector<std::string> paths(files);
+  std::vector<INDEX> expected(files);
+  for (UINT i = 0; i < files; i++) {
+    paths[ i ] = std::string(dir) + "/ramp" + std::to_string(i);
+    expected[ i ] = (((INDEX) rand() << 31) ^ (INDEX) rand()) % size;
+    errors += !WriteRampFile(paths[ i ].c_str(), size, expected[ i ]);
+  }
+  std::cout << files << " files of " << size << " elements in " << dir << std::endl;
+
+  UINT cpus = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  for (UINT threads : { 1u, cpus }) {
+    UINT failed;
+    for (const std::string &path : paths)
+      DropFileCache(path.c_str());
+    double start = NowNs();
+    UINT written = BuildSidecars(dir, threads, &failed);
+    printf("build, %2u thread(s): %8.2f ms\n", threads, (NowNs() - start) / 1e6);
+    errors += written != files || failed;
+  }
+
+  printf("%-10s %10s %12s\n", "startup", "us/file", "read_kb/file");
+  for (UINT m = 0; m < 2; m++) {
+    for (const std::string &path : paths) {
+      DropFileCache(path.c_str());
+      DropFileCache(SidecarPath(path.c_str()).c_str());
+    }
+    PageStats before, after;
+    ReadPageStats(&before);
+    double start = NowNs();
+    for (UINT i = 0; i < files; i++) {
+      INDEX idx = ~(INDEX) 0;
+      if (m) {
+        errors += LoadRampStart(paths[ i ].c_str(), &idx) != SIDECAR_VALID;
+      } else {
+        MappedRamp ramp;
+        UINT tries = 0;
+        if (MapRamp(paths[ i ].c_str(), &ramp)) {
+          idx = PivotToStart(ramp.container, ramp.size, FindRampPivotPaged(ramp.container, ramp.size, &tries));
+          UnmapRamp(&ramp);
+        }
+      }
+      errors += idx != expected[ i ];
+    }
+    double us = (NowNs() - start) / 1e3 / files;
+    ReadPageStats(&after);
+    printf("%-10s %10.1f %12.1f\n", m ? "sidecar" : "search", us,
+        (double) (after.read_bytes - before.read_bytes) / 1024 / files);
+  }
+
+  // A rewritten file must not be served from its old sidecar
+  INDEX idx;
+  expected[ 0 ] = (expected[ 0 ] + size / 2) % size;
+  WriteRampFile(paths[ 0 ].c_str(), size, expected[ 0 ]);
+  errors += LoadRampStart(paths[ 0 ].c_str(), &idx) != SIDECAR_REBUILT || idx != expected[ 0 ];
+  errors += LoadRampStart(paths[ 0 ].c_str(), &idx) != SIDECAR_VALID || idx != expected[ 0 ];
+
+  for (const std::string &path : paths) {
+    unlink(path.c_str());
+    unlink(SidecarPath(path.c_str()).c_str());
+  }
+  rmdir(dir);
+
+  if (errors) {
+    std::cout << "SIDECAR ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchSegments
+// Write a circular log over segment files at several rotations, seams on
+// segment boundaries included, and find its oldest record: the segment
+// search against scanning the first record of every segment before
+// bisecting the wrapping one.  Reads and times are per search, with the
+// segments in the page cache.
+// Entry: optional number of segments (default 64)
+//        optional segment size in kilobytes (default 256)
+// Exit: 0 on success, nonzero if an oldest record is wrong
+static int BenchSegments(int argc, char *argv[])
+{
+  const UINT ROTATIONS = 16;
+  const UINT LOOKUPS = 256;
+  UINT segments = argc > 0 && strtoul(argv[ 0 ], nullptr, 10) ? (UINT) strtoul(argv[ 0 ], nullptr, 10) : 64;
+  size_t kb = argc > 1 && strtoul(argv[ 1 ], nullptr, 10) ? strtoul(argv[ 1 ], nullptr, 10) : 256;
+  SIZE segmentSize = (SIZE) std::max<size_t>((kb << 10) / sizeof(CONTAINER), 1);
+  INDEX total = (INDEX) segmentSize * segments;
+  char dir[] = "/tmp/findramp_segments.XXXXXX";
+  UINT errors = 0;
+
+  if (!mkdtemp(dir)) {
+    std::cout << "Cannot create a directory in /tmp" << std::endl;
+    return -1;
+  }
+  std::vector<std::string> paths(segments);
+  for (UINT s = 0; s < segments; s++)
+    paths[ s ] = std::string(dir) + "/segment" + std::to_string(s);
+  std::cout << segments << " segments of " << segmentSize << " records" << std::endl;
+
+  double reads[ 2 ] = { 0, 0 }, ns[ 2 ] = { 0, 0 };
+  for (UINT r = 0; r < ROTATIONS; r++) {
+    INDEX startIdx = (r & 1) ? (INDEX) (rand() % segments) * segmentSize :
+      (((INDEX) rand() << 31) ^ (INDEX) rand()) % total;
+    SegmentLog log;
+    if (!WriteSegmentLog(paths, segmentSize, startIdx) || !OpenSegmentLog(paths, &log)) {
+      std::cout << "Cannot write segments in " << dir << std::endl;
+      errors++;
+      break;
+    }
+    for (UINT m = 0; m < 2; m++) {
+      UINT count = 0;
+      LogPosition oldest = { 0, 0 };
+      double start = NowNs();
+      for (UINT i = 0; i < LOOKUPS; i++) {
+        if (m == 0) {
+          errors += !FindOldestRecord(&log, &oldest, &count);
+        } else {
+          // Scan every segment's first record, then bisect the wrapping one
+          CONTAINER first, value;
+          ReadLogRecord(&log, { 0, 0 }, &first);
+          UINT seg = 0;
+          for (UINT s = 1; s < segments; s++) {
+            ReadLogRecord(&log, { s, 0 }, &value);
+            seg = value >= first ? s : seg;
+          }
+          count += segments;
+          INDEX base = 0, n = (INDEX) segmentSize;
+          while (n > 1) {
+            INDEX half = n >> 1;
+            ReadLogRecord(&log, { seg, base + half }, &value);
+            base = value >= first ? base + half : base;
+            n -= half;
+            count++;
+          }
+          oldest.segment = seg;
+          oldest.record = base + 1;
+          if (oldest.record == (INDEX) segmentSize)
+            oldest = { seg + 1 < segments ? seg + 1 : 0, 0 };
+        }
+      }
+      ns[ m ] += (NowNs() - start) / LOOKUPS;
+      reads[ m ] += (double) count / LOOKUPS;
+      errors += (INDEX) oldest.segment * segmentSize + oldest.record != startIdx;
+    }
+    CloseSegmentLog(&log);
+  }
+  printf("%-12s %10s %10s\n", "method", "us", "reads");
+  printf("%-12s %10.2f %10.1f\n", "segment", ns[ 0 ] / 1e3 / ROTATIONS, reads[ 0 ] / ROTATIONS);
+  printf("%-12s %10.2f %10.1f\n", "scan", ns[ 1 ] / 1e3 / ROTATIONS, reads[ 1 ] / ROTATIONS);
+
+  for (const std::string &path : paths)
+    unlink(path.c_str());
+  rmdir(dir);
+
+  if (errors) {
+    std::cout << "SEGMENT ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchRecord
+// A fixed-size record keyed by its first field
+template <size_t Bytes>
+struct BenchRecord {
+  CONTAINER key;
+  unsigned char payload[ Bytes - sizeof(CONTAINER) ];
+};
+
+// BenchRecordSize
+// Time lower-bound lookups and cold ramp-start searches over an array of
+// BenchRecord<Bytes>, through a run-time stride and through a projection,
+// and print a row for each
+// Entry: key column of the ramp
+//        ramp start
+//        lookup keys
+//        expected logical offsets of the lookups
+//        pointer to error count (accumulated)
+template <size_t Bytes>
+static void BenchRecordSize(const std::vector<CONTAINER> &column, INDEX startIdx,
+    const std::vector<CONTAINER> &keys, const std::vector<INDEX> &expected, UINT *errors)
+{
+  const UINT COLD = 8;
+  const INDEX size = column.size();
+  std::vector<BenchRecord<Bytes>> records(size);
+  for (INDEX i = 0; i < size; i++)
+    records[ i ].key = column[ i ];
+  auto proj = [](const BenchRecord<Bytes> &r) { return r.key; };
+  ramp::StridedKeys<CONTAINER> strided(records.data(), sizeof(BenchRecord<Bytes>),
+      offsetof(BenchRecord<Bytes>, key));
+  ramp::ProjectedKeys<BenchRecord<Bytes>, decltype(proj)> projected(records.data(), proj);
+
+  for (UINT m = 0; m < 2; m++) {
+    double start = NowNs();
+    for (UINT i = 0; i < keys.size(); i++) {
+      INDEX pos = m ? ramp::LowerBoundBy(projected, size, startIdx, keys[ i ]) :
+        ramp::LowerBoundBy(strided, size, startIdx, keys[ i ]);
+      *errors += pos != expected[ i ];
+    }
+    double key_ns = (NowNs() - start) / keys.size();
+
+    double cold_ns = 0;
+    UINT tries = 0;
+    for (UINT r = 0; r < COLD; r++) {
+      EvictCaches(256 << 20);
+      start = NowNs();
+      INDEX found = m ? ramp::FindStartRecords<BenchRecord<Bytes>, INDEX>(records.data(), size, proj) :
+        FindRampStartStrided(records.data(), size, sizeof(BenchRecord<Bytes>), 0, &tries);
+      cold_ns += NowNs() - start;
+      *errors += found != startIdx;
+    }
+    printf("%8zu %-10s %10.1f %10.1f %10.2f\n", Bytes, m ? "projected" : "strided",
+        (double) size * Bytes / (1 << 20), key_ns, cold_ns / COLD / 1e3);
+  }
+}
+
+// BenchRecords
+// Cost of searching array-of-structs records against a separate key
+// column.  A probe into records of a cache line or more brings in a line
+// for one key, so the records' working set grows with the record size
+// while the column's stays at four bytes a key.  Lower-bound lookups use
+// random keys against a warm cache; cold starts find the ramp start after
+// evicting the caches.
+// Entry: optional key column size in megabytes (default 16)
+// Exit: 0 on success, nonzero if a result is wrong
+static int BenchRecords(int argc, char *argv[])
+{
+  const UINT LOOKUPS = 1 << 20;
+  const UINT COLD = 8;
+  size_t mb = BenchPoolMb(argc, argv, 16);
+  INDEX size = std::min<size_t>((mb << 20) / sizeof(CONTAINER), BENCH_MAX_SIZE);
+  INDEX startIdx = 1 + rand() % (size - 1);
+  UINT errors = 0;
+
+  // Even keys, so half the lookups miss
+  std::vector<CONTAINER> column(size);
+  for (INDEX i = 0; i < size; i++)
+    column[ i ] = ((i + size - startIdx) % size) * 2;
+  std::vector<CONTAINER> keys(LOOKUPS);
+  std::vector<INDEX> expected(LOOKUPS);
+  for (UINT i = 0; i < LOOKUPS; i++)
+    keys[ i ] = rand() % (2 * size);
+
+  std::cout << size << " records" << std::endl;
+  printf("%8s %-10s %10s %10s %10s\n", "bytes", "layout", "MB", "key_ns", "cold_us");
+  double start = NowNs();
+  for (UINT i = 0; i < LOOKUPS; i++)
+    expected[ i ] = ramp::LowerBoundBy(column.data(), size, startIdx, keys[ i ]);
+  double key_ns = (NowNs() - start) / LOOKUPS;
+  double cold_ns = 0;
+  for (UINT r = 0; r < COLD; r++) {
+    EvictCaches(256 << 20);
+    start = NowNs();
+    errors += ramp::FindStartBy(column.data(), size) != startIdx;
+    cold_ns += NowNs() - start;
+  }
+  for (UINT i = 0; i < LOOKUPS; i += LOOKUPS / 64)
+    errors += expected[ i ] != ramp::LowerBound(column.data(), size, startIdx, keys[ i ]);
+  printf("%8zu %-10s %10.1f %10.1f %10.2f\n", sizeof(CONTAINER), "column",
+      (double) size * sizeof(CONTAINER) / (1 << 20), key_ns, cold_ns / COLD / 1e3);
+
+  BenchRecordSize<8>(column, startIdx, keys, expected, &errors);
+  BenchRecordSize<16>(column, startIdx, keys, expected, &errors);
+  BenchRecordSize<32>(column, startIdx, keys, expected, &errors);
+  BenchRecordSize<64>(column, startIdx, keys, expected, &errors);
+  BenchRecordSize<128>(column, startIdx, keys, expected, &errors);
+
+  if (errors) {
+    std::cout << "RECORD ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchSerial
+// Serial-number order against plain integer order.  Pools of ramps start
+// at 0 or just below 2^32, so the wrapped ramps straddle the wrap point;
+// the plain order gets those wrong and is timed only on the unwrapped
+// pool.  Unique-key bisection and the duplicate-correct plateau search
+// are timed in each order.
+// Exit: 0 on success, nonzero if a serial search misses the oldest element
+static int BenchSerial(int argc, char *argv[])
+{
+  const SIZE sizes[] = { 1024, 65536, 1048576 };
+  const UINT COUNT = 16;
+  const UINT LOOKUPS = 1 << 20;
+  const char *names[] = { "plain", "serial", "serial_wrap" };
+  std::less<CONTAINER> plain;
+  ramp::SerialLess<CONTAINER> serial;
+  UINT errors = 0;
+
+  printf("%10s %-12s %10s %10s %12s\n", "size", "order", "unique_ns", "dupes_ns", "plain_wrong");
+  for (SIZE size : sizes) {
+    std::vector<UINT> order(LOOKUPS);
+    for (UINT &r : order)
+      r = rand() % COUNT;
+    for (UINT m = 0; m < 3; m++) {
+      std::vector<std::vector<CONTAINER>> unique(COUNT), dupes(COUNT);
+      std::vector<CONTAINER> bases(COUNT);
+      for (UINT r = 0; r < COUNT; r++) {
+        bases[ r ] = m == 2 ? (CONTAINER) 0 - 1 - rand() % size : 0;
+        unique[ r ].resize(size);
+        dupes[ r ].resize(size);
+        GenerateRamp(unique[ r ].data(), size, rand() % size, false, bases[ r ]);
+        GenerateRamp(dupes[ r ].data(), size, rand() % size, true, bases[ r ]);
+      }
+
+      double ns[ 2 ];
+      UINT wrong = 0;
+      for (UINT d = 0; d < 2; d++) {
+        std::vector<std::vector<CONTAINER>> &pool = d ? dupes : unique;
+        double start = NowNs();
+        for (UINT i = 0; i < LOOKUPS; i++) {
+          const CONTAINER *container = pool[ order[ i ] ].data();
+          INDEX idx;
+          if (!d)
+            idx = m ? ramp::FindStart(container, (INDEX) size, serial) : ramp::FindStart(container, (INDEX) size, plain);
+          else
+            idx = m ? ramp::FindStartDuplicates(container, (INDEX) size, serial) :
+              ramp::FindStartDuplicates(container, (INDEX) size, plain);
+          bench_sink = idx;
+        }
+        ns[ d ] = (NowNs() - start) / LOOKUPS;
+
+        for (UINT r = 0; r < COUNT; r++) {
+          const CONTAINER *container = pool[ r ].data();
+          INDEX idx = d ? ramp::FindStartDuplicates(container, (INDEX) size, serial) :
+            ramp::FindStart(container, (INDEX) size, serial);
+          errors += container[ idx ] != bases[ r ] || (idx && container[ idx - 1 ] == bases[ r ]);
+          INDEX plain_idx = d ? ramp::FindStartDuplicates(container, (INDEX) size, plain) :
+            ramp::FindStart(container, (INDEX) size, plain);
+          wrong += container[ plain_idx ] != bases[ r ];
+        }
+      }
+      printf("%10ld %-12s %10.1f %10.1f %12u\n", size, names[ m ], ns[ 0 ], ns[ 1 ], wrong);
+    }
+  }
+
+  if (errors) {
+    std::cout << "SERIAL ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchGenerate
+// Time setting up a large container from a fresh allocation, so the
+// first-touch page faults are part of the cost: GenerateRamp against
+// GenerateRampParallel on one thread and on one thread per CPU, with and
+// without duplicates
+// Entry: optional container size in megabytes (default 1024)
+// Exit: 0 on success, nonzero if a generated ramp does not start at its
+//       start index
+static int BenchGenerate(int argc, char *argv[])
+{
+  size_t mb = BenchPoolMb(argc, argv, 1024);
+  SIZE size = (SIZE) ((mb << 20) / sizeof(CONTAINER));
+  UINT cpus = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  UINT errors = 0;
+
+  std::cout << size << " elements, " << cpus << " CPUs" << std::endl;
+  printf("%-14s %6s %10s %10s\n", "method", "dupes", "ms", "GB/s");
+  for (UINT d = 0; d < 2; d++) {
+    for (UINT m = 0; m < 3; m++) {
+      CONTAINER *container = AllocContainer(size);
+      if (!container) {
+        std::cout << "Cannot allocate " << mb << " MB" << std::endl;
+        return -1;
+      }
+      INDEX startIdx = (((INDEX) rand() << 31) ^ (INDEX) rand()) % size;
+      double start = NowNs();
+      if (m == 0)
+        GenerateRamp(container, size, startIdx, d);
+      else
+        GenerateRampParallel(container, size, startIdx, d, 0, m == 1 ? 1 : cpus);
+      double ms = (NowNs() - start) / 1e6;
+      UINT tries = 0;
+      INDEX idx = FindRampStart(container, size, &tries, ENGINE_PLATEAU);
+      errors += container[ idx ] != 0 || (idx != startIdx && !d);
+      char label[ 32 ];
+      snprintf(label, sizeof(label), m == 0 ? "serial" : "parallel x%u", m == 1 ? 1 : cpus);
+      printf("%-14s %6s %10.1f %10.2f\n", label, d ? "yes" : "no", ms,
+          (double) size * sizeof(CONTAINER) / ms / 1e6);
+      FreeContainer(container);
+    }
+  }
+
+  if (errors) {
+    std::cout << "GENERATE ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchView
+// Logical-order access to a rotated ramp without unrotating it.  A full
+// scan sums the ramp by rotating a copy first, by a modulo per element,
+// through RotatedView iterators and through the segmented ForEach;
+// lookups compare std::lower_bound over the view with ramp::LowerBound.
+// Entry: optional container size in megabytes (default 64)
+// Exit: 0 on success, nonzero if the methods disagree
+static int BenchView(int argc, char *argv[])
+{
+  const UINT REPS = 8;
+  const UINT LOOKUPS = 1 << 20;
+  size_t mb = BenchPoolMb(argc, argv, 64);
+  SIZE size = (SIZE) ((mb << 20) / sizeof(CONTAINER));
+  CONTAINER *container = AllocContainer(size);
+  INDEX startIdx = (((INDEX) rand() << 31) ^ (INDEX) rand()) % size;
+  GenerateRamp(container, size, startIdx, false);
+  ramp::RotatedView<const CONTAINER, INDEX> view(container, size, startIdx);
+  std::vector<CONTAINER> copy(size);
+  const char *names[] = { "rotate_copy", "modulo", "iterator", "segments" };
+  UINT errors = 0;
+
+  printf("%-12s %10s\n", "scan", "ns/elem");
+  uint64_t expected = (uint64_t) size * (size - 1) / 2;
+  for (UINT m = 0; m < 4; m++) {
+    double start = NowNs();
+    for (UINT r = 0; r < REPS; r++) {
+      uint64_t sum = 0;
+      if (m == 0) {
+        std::rotate_copy(container, container + startIdx, container + size, copy.begin());
+        for (SIZE i = 0; i < size; i++)
+          sum += copy[ i ];
+      } else if (m == 1) {
+        for (SIZE i = 0; i < size; i++)
+          sum += container[ (startIdx + i) % size ];
+      } else if (m == 2) {
+        sum = std::accumulate(view.begin(), view.end(), (uint64_t) 0);
+      } else {
+        view.ForEach([&](CONTAINER v) { sum += v; });
+      }
+      errors += sum != expected;
+    }
+    printf("%-12s %10.3f\n", names[ m ], (NowNs() - start) / REPS / size);
+  }
+
+  std::vector<CONTAINER> keys(LOOKUPS);
+  for (CONTAINER &key : keys)
+    key = rand() % size;
+  printf("%-12s %10s\n", "lookup", "ns");
+  for (UINT m = 0; m < 2; m++) {
+    double start = NowNs();
+    for (UINT i = 0; i < LOOKUPS; i++) {
+      INDEX pos = m ? ramp::LowerBound(container, (INDEX) size, startIdx, keys[ i ]) :
+        (INDEX) (std::ranges::lower_bound(view, keys[ i ]) - view.begin());
+      errors += pos != keys[ i ];
+    }
+    printf("%-12s %10.1f\n", m ? "LowerBound" : "view", (NowNs() - start) / LOOKUPS);
+  }
+  FreeContainer(container);
+
+  if (errors) {
+    std::cout << "VIEW ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchMirror
+// Sequential reductions over a rotated ramp in logical order: modulo
+// indexing and RotatedView over an AllocContainer buffer, against a
+// single loop over the contiguous logical range of an
+// AllocMirroredContainer buffer.  The sum can be split at the wrap, so
+// the view walks its two segments; the sum of adjacent differences
+// reads pairs that straddle it, so the view goes through its iterators.
+// Run at a cache-resident size and at a size in DRAM.
+// Entry: optional large container size in megabytes (default 256)
+// Exit: 0 on success, nonzero if the sums disagree
+static int BenchMirror(int argc, char *argv[])
+{
+  const UINT REPS = 8;
+  const char *names[] = { "modulo", "view", "mirrored" };
+  size_t mbs[] = { 1, BenchPoolMb(argc, argv, 256) };
+  UINT errors = 0;
+
+  printf("%10s %-10s %10s %10s %12s\n", "size", "method", "sum_ns", "sum_GB/s", "pairs_ns");
+  for (size_t mb : mbs) {
+    SIZE size = MirroredSize((SIZE) ((mb << 20) / sizeof(CONTAINER)));
+    CONTAINER *plain = AllocContainer(size);
+    CONTAINER *mirror = AllocMirroredContainer(size);
+    if (!plain || !mirror) {
+      std::cout << "Cannot allocate " << mb << " MB" << std::endl;
+      FreeContainer(plain);
+      FreeMirroredContainer(mirror, size);
+      return -1;
+    }
+    INDEX startIdx = (((INDEX) rand() << 31) ^ (INDEX) rand()) % size;
+    GenerateRamp(plain, size, startIdx, false);
+    GenerateRamp(mirror, size, startIdx, false);
+    ramp::RotatedView<const CONTAINER, INDEX> view(plain, size, startIdx);
+    const CONTAINER *logical = mirror + startIdx;
+    const uint64_t expected = (uint64_t) size * (size - 1) / 2;
+
+    for (UINT m = 0; m < 3; m++) {
+      double ns[ 2 ];
+      for (UINT q = 0; q < 2; q++) {
+        double start = 0;
+        for (UINT r = 0; r <= REPS; r++) {
+          // The first pass warms the caches and the second mapping's page tables
+          if (r == 1)
+            start = NowNs();
+          uint64_t sum = 0;
+          if (q == 0 && m == 0) {
+            for (SIZE i = 0; i < size; i++)
+              sum += plain[ (startIdx + i) % size ];
+          } else if (q == 0 && m == 1) {
+            view.ForEach([&](CONTAINER v) { sum += v; });
+          } else if (q == 0) {
+            for (SIZE i = 0; i < size; i++)
+              sum += logical[ i ];
+          } else if (m == 0) {
+            for (SIZE i = 0; i + 1 < size; i++)
+              sum += plain[ (startIdx + i + 1) % size ] - plain[ (startIdx + i) % size ];
+          } else if (m == 1) {
+            auto it = view.begin();
+            for (SIZE i = 0; i + 1 < size; i++, ++it)
+              sum += it[ 1 ] - it[ 0 ];
+          } else {
+            for (SIZE i = 0; i + 1 < size; i++)
+              sum += logical[ i + 1 ] - logical[ i ];
+          }
+          errors += sum != (q ? (uint64_t) size - 1 : expected);
+        }
+        ns[ q ] = (NowNs() - start) / REPS / size;
+      }
+      printf("%10ld %-10s %10.3f %10.2f %12.3f\n", size, names[ m ], ns[ 0 ], sizeof(CONTAINER) / ns[ 0 ], ns[ 1 ]);
+    }
+    FreeContainer(plain);
+    FreeMirroredContainer(mirror, size);
+  }
+
+  if (errors) {
+    std::cout << "MIRROR ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// BenchUnrotate
+// Unrotate a ramp into sorted order: std::rotate in place, std::rotate_copy
+// and UnrotateCopy into a freshly allocated buffer, and UnrotateContainer
+// on one thread, four threads and one per CPU.  Starts cover an even split, an uneven
+// one left to the block swaps and a short side left to the buffered shift.
+static int BenchUnrotate(int argc, char *argv[])
+{
+  const UINT REPS = 3;
+  const char *names[] = { "std::rotate", "rotate_copy", "copy", "unrotate", "unrotate", "unrotate" };
+  const UINT cpus = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  const UINT threads[] = { 1, 1, cpus, 1, 4, cpus };
+  size_t mbs[] = { 1, BenchPoolMb(argc, argv, 64) };
+  UINT errors = 0;
+
+  printf("%10s %10s %-12s %8s %10s %10s\n", "size", "start", "method", "threads", "ms", "GB/s");
+  for (size_t mb : mbs) {
+    SIZE size = (SIZE) ((mb << 20) / sizeof(CONTAINER));
+    CONTAINER *pristine = AllocContainer(size);
+    CONTAINER *container = AllocContainer(size);
+    if (!pristine || !container) {
+      std::cout << "Cannot allocate " << mb << " MB" << std::endl;
+      FreeContainer(pristine);
+      FreeContainer(container);
+      return -1;
+    }
+    INDEX starts[] = { (INDEX) size / 2, (INDEX) size / 3, (INDEX) size - 1000 };
+    for (INDEX startIdx : starts) {
+      GenerateRamp(pristine, size, startIdx, false);
+      for (UINT m = 0; m < 6; m++) {
+        double ns = 0;
+        for (UINT r = 0; r < REPS; r++) {
+          memcpy(container, pristine, size * sizeof(CONTAINER));
+          double start = NowNs();
+          if (m == 0) {
+            std::rotate(container, container + startIdx, container + size);
+          } else if (m <= 2) {
+            CONTAINER *copy = AllocContainer(size);
+            if (m == 1)
+              std::rotate_copy(container, container + startIdx, container + size, copy);
+            else
+              UnrotateCopy(copy, container, size, startIdx, threads[ m ]);
+            FreeContainer(container);
+            container = copy;
+          } else {
+            UnrotateContainer(container, size, startIdx, threads[ m ]);
+          }
+          ns += NowNs() - start;
+          for (SIZE i = 0; i < size; i++)
+            errors += container[ i ] != (CONTAINER) i;
+        }
+        ns /= REPS;
+        printf("%10ld %10lu %-12s %8u %10.3f %10.2f\n", size, startIdx, names[ m ], threads[ m ],
+            ns / 1e6, size * sizeof(CONTAINER) / ns);
+      }
+    }
+    FreeContainer(pristine);
+    FreeContainer(container);
+  }
+
+  if (errors) {
+    std::cout << "UNROTATE ERRORS: " << errors << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// Benchmark
+// Registry entry for a named benchmark
+struct Benchmark {
+  const char *name;
+  int (*run)(int argc, char *argv[]);
+  const char *desc;
+};
+
+static const Benchmark benchmarks[] = {
+  { "engines", BenchEngines, "recursive vs branchless engine, sizes 1..10M" },
+  { "simd", BenchSimd, "branchless vs hybrid vector-scan engine per ISA" },
+  { "batch", BenchBatch, "sequential vs batched lookups, [pool_mb] (default 256)" },
+  { "coro", BenchCoro, "sequential vs batch vs coroutine lookups on mixed sizes, [pool_mb]" },
+  { "dupes", BenchDupes, "linear vs galloping duplicate-run skip by density, [size]" },
+  { "plateau", BenchPlateau, "engine speed and wrong answers on ramps with duplicates" },
+  { "generic", BenchGeneric, "template library per key type vs CONTAINER engines" },
+  { "keys", BenchKeys, "rotated lower_bound vs single pass vs std::rotate + lower_bound" },
+  { "dense", BenchDense, "closed-form dense engine vs bisection, with fallback cost" },
+  { "predict", BenchPredict, "interpolation / fitted model vs bisection by distribution, [size]" },
+  { "hint", BenchHint, "cold search vs galloping from the previous start by advance, [size]" },
+  { "ring", BenchRing, "RotatedRamp push with tracked head vs cold search, Recover check, [size]" },
+  { "kary", BenchKary, "binary vs k-ary (k = 4, 8, 16) search at L2/L3/DRAM sizes, [dram_mb]" },
+  { "layout", BenchLayout, "Eytzinger / B+ tree layouts vs linear: build cost, lookups, crossover" },
+  { "sample", BenchSample, "plain vs sample-indexed pivot and key searches on a large pool, [pool_mb]" },
+  { "mmap", BenchMmap, "cold mapped-file lookups: faults and bytes read, [file_mb] [dir]" },
+  { "uring", BenchUring, "direct-I/O pread bisection vs io_uring k-ary rounds, [file_mb] [dir]" },
+  { "sidecar", BenchSidecar, "cold startup: search vs sidecar load, parallel build, [files] [file_mb]" },
+  { "segments", BenchSegments, "oldest record of a segmented ring log: segment search vs scan, [segments] [segment_kb]" },
+  { "records", BenchRecords, "array-of-structs records (strided, projected) vs key column, [column_mb]" },
+  { "serial", BenchSerial, "RFC 1982 serial-number order vs plain order, wrapped ramps" },
+  { "generate", BenchGenerate, "first-touch setup of a large container, serial vs parallel, [mb]" },
+  { "view", BenchView, "logical-order scans and lookups: copy, modulo, RotatedView, segments, [mb]" },
+  { "mirror", BenchMirror, "logical-order reduction: modulo vs view segments vs double-mapped ring, [mb]" },
+  { "unrotate", BenchUnrotate, "unrotation: std::rotate vs copies to a new buffer vs blocked swaps, [mb]" },
+};
+
+// PrintBenchmarks
+// List the available benchmarks to stdout
+void PrintBenchmarks()
+{
+  for (const Benchmark &b : benchmarks)
+    printf("\t%-12s%s\n", b.name, b.desc);
+}
+
+// RunBenchmark
+// Run a benchmark by name
+// Entry: benchmark name
+//        remaining argument count
+//        remaining arguments
+// Exit: benchmark result, -1 if the name is unknown
+int RunBenchmark(const char *name, int argc, char *argv[])
+{
+  for (const Benchmark &b : benchmarks) {
+    if (!strcmp(name, b.name))
+      return b.run(argc, argv);
+  }
+  std::cout << "Unknown benchmark: " << name << std::endl;
+  PrintBenchmarks();
+  return -1;
+}
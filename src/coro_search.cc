@@ -0,0 +1,163 @@
+// Coroutine pivot search and its interleaving scheduler.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <cassert>
+#include <exception>
+#include <new>
+#include <vector>
+
+#include "coro_search.h"
+
+// Free list of coroutine frames.  Only as many frames as there are
+// searches in flight are ever live, so recycled frames are kept for the
+// life of the thread rather than returned to the heap.
+struct FreeFrame {
+  FreeFrame *next;
+};
+static thread_local FreeFrame *free_frames = nullptr;
+static thread_local size_t free_frame_bytes = 0;
+
+void *PivotSearch::promise_type::operator new(size_t bytes)
+{
+  if (free_frames && bytes == free_frame_bytes) {
+    FreeFrame *frame = free_frames;
+    free_frames = frame->next;
+    return frame;
+  }
+  return ::operator new(bytes);
+}
+
+void PivotSearch::promise_type::operator delete(void *frame, size_t bytes)
+{
+  if (!free_frame_bytes)
+    free_frame_bytes = bytes;
+  if (bytes != free_frame_bytes) {
+    ::operator delete(frame);
+    return;
+  }
+  FreeFrame *free_frame = static_cast<FreeFrame *>(frame);
+  free_frame->next = free_frames;
+  free_frames = free_frame;
+}
+
+void PivotSearch::promise_type::unhandled_exception()
+{
+  std::terminate();
+}
+
+PivotSearch &PivotSearch::operator=(PivotSearch &&other) noexcept
+{
+  if (this != &other) {
+    if (handle_)
+      handle_.destroy();
+    handle_ = other.handle_;
+    other.handle_ = nullptr;
+  }
+  return *this;
+}
+
+PivotSearch::~PivotSearch()
+{
+  if (handle_)
+    handle_.destroy();
+}
+
+// FindRampPivotCoro
+// Branchless bisection as FindRampPivotBranchless, suspending after the
+// prefetch of every midpoint.  The coroutine starts suspended; the first
+// resume issues the prefetches for container[ 0 ] and the first midpoint.
+// Entry: pointer to container
+//        size of container in elements
+//        pointer to tries (for complexity analyis)
+// Exit: search handle; Pivot() is valid once Done()
+PivotSearch FindRampPivotCoro(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  const CONTAINER *base = container;
+  INDEX n = size;
+  UINT steps = 0;
+  __builtin_prefetch(container);
+  __builtin_prefetch(base + (n >> 1));
+  co_await std::suspend_always{};
+
+  const CONTAINER first = container[ 0 ];
+  while (n > 1) {
+    INDEX half = n >> 1;
+    base = (base[ half ] >= first) ? base + half : base;
+    n -= half;
+    steps++;
+    if (n > 1) {
+      __builtin_prefetch(base + (n >> 1));
+      co_await std::suspend_always{};
+    }
+  }
+  *tries += steps + 1;
+  co_return (INDEX) (base - container);
+}
+
+// FindRampStartInterleaved
+// Find the ramp start of many independent containers, keeping up to
+// width coroutine searches in flight.  Results match FindRampStart with
+// ENGINE_BRANCHLESS for each ramp.
+// Entry: pointer to ramps
+//        number of ramps
+//        pointer to ramp starts, one per ramp (out)
+//        pointer to tries, one per ramp, accumulated (may be nullptr)
+//        number of searches in flight
+void FindRampStartInterleaved(
+    const RampRef *ramps,
+    UINT count,
+    INDEX *starts,
+    UINT *tries,
+    UINT width)
+{
+  struct Slot {
+    PivotSearch search;
+    UINT ramp = ~0u;              // ~0 marks an empty slot
+  };
+  std::vector<Slot> slots(width ? width : 1);
+  UINT scratch_tries = 0;
+  UINT next = 0;
+  UINT live = 0;
+
+  // Start the search for the next queued ramp in a slot and issue its
+  // first prefetches
+  auto launch = [&](Slot &slot) {
+    const RampRef &ramp = ramps[ next ];
+    assert(ramp.size);
+    slot.ramp = next++;
+    slot.search = FindRampPivotCoro(ramp.container, ramp.size,
+        tries ? &tries[ slot.ramp ] : &scratch_tries);
+    slot.search.Resume();
+    live++;
+  };
+
+  for (Slot &slot : slots) {
+    if (next == count)
+      break;
+    launch(slot);
+  }
+
+  while (live) {
+    for (Slot &slot : slots) {
+      if (slot.ramp == (UINT) ~0)
+        continue;
+      slot.search.Resume();
+      if (!slot.search.Done())
+        continue;
+
+      const RampRef &ramp = ramps[ slot.ramp ];
+      starts[ slot.ramp ] = PivotToStart(ramp.container, ramp.size, slot.search.Pivot());
+      live--;
+      if (next < count) {
+        launch(slot);
+      } else {
+        slot.search = PivotSearch();
+        slot.ramp = ~0;
+      }
+    }
+  }
+}
@@ -0,0 +1,373 @@
+// Vectorized scans used by the pivot search.
+//
+// Once the bisection window shrinks to a few cache lines, a linear scan
+// for the first container[i] > container[i + 1] is cheaper than further
+// dependent halvings.  The scan compares whole vectors of CONTAINER values
+// and takes the first descent with a movemask/tzcnt.
+//
+// The same machinery finds the first element different from a value,
+// which is how plateaus of duplicates that bisection cannot see into are
+// crossed.
+//
+// The k-ary search gathers k evenly spaced separators per level into one
+// register and counts how many lie before the seam with a single compare,
+// cutting the number of dependent loads from log2(n) to logk(n).
+//
+// The widest instruction set supported by the CPU is selected at runtime;
+// the scalar scan is always available as a fallback.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <cassert>
+#include <immintrin.h>
+
+#include "find_pivot.h"
+
+// FindDescentScalar
+// Entry: pointer to first element of the window
+//        number of adjacent pairs to compare (count + 1 elements are read)
+// Exit: offset of the first descent, count if there is none
+static INDEX FindDescentScalar(const CONTAINER *container, INDEX count)
+{
+  for (INDEX i = 0; i < count; i++) {
+    if (container[ i ] > container[ i + 1 ])
+      return i;
+  }
+  return count;
+}
+
+// FindDescentAvx2
+// AVX2 has no unsigned compare, so a > b is derived from min(a, b) != a.
+// Entry/Exit: as FindDescentScalar
+__attribute__((target("avx2,bmi")))
+static INDEX FindDescentAvx2(const CONTAINER *container, INDEX count)
+{
+  INDEX i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i a = _mm256_loadu_si256((const __m256i *) (container + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *) (container + i + 1));
+    __m256i le = _mm256_cmpeq_epi32(_mm256_min_epu32(a, b), a);
+    UINT mask = ~(UINT) _mm256_movemask_ps(_mm256_castsi256_ps(le)) & 0xff;
+    if (mask)
+      return i + _tzcnt_u32(mask);
+  }
+  return i + FindDescentScalar(container + i, count - i);
+}
+
+// FindDescentAvx512
+// Masked loads cover the tail, so no scalar remainder loop is needed.
+// Entry/Exit: as FindDescentScalar
+__attribute__((target("avx512f,bmi")))
+static INDEX FindDescentAvx512(const CONTAINER *container, INDEX count)
+{
+  for (INDEX i = 0; i < count; i += 16) {
+    INDEX left = count - i;
+    __mmask16 live = left >= 16 ? 0xffff : (__mmask16) ((1u << left) - 1);
+    __m512i a = _mm512_maskz_loadu_epi32(live, container + i);
+    __m512i b = _mm512_maskz_loadu_epi32(live, container + i + 1);
+    __mmask16 gt = _mm512_mask_cmpgt_epu32_mask(live, a, b);
+    if (gt)
+      return i + _tzcnt_u32(gt);
+  }
+  return count;
+}
+
+// FindNotEqualScalar
+// Entry: pointer to first element
+//        number of elements to compare
+//        value to skip
+// Exit: offset of the first element != value, count if there is none
+static INDEX FindNotEqualScalar(const CONTAINER *container, INDEX count, CONTAINER value)
+{
+  for (INDEX i = 0; i < count; i++) {
+    if (container[ i ] != value)
+      return i;
+  }
+  return count;
+}
+
+// FindNotEqualAvx2
+// Entry/Exit: as FindNotEqualScalar
+__attribute__((target("avx2,bmi")))
+static INDEX FindNotEqualAvx2(const CONTAINER *container, INDEX count, CONTAINER value)
+{
+  const __m256i x = _mm256_set1_epi32((int) value);
+  INDEX i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i a = _mm256_loadu_si256((const __m256i *) (container + i));
+    __m256i eq = _mm256_cmpeq_epi32(a, x);
+    UINT mask = ~(UINT) _mm256_movemask_ps(_mm256_castsi256_ps(eq)) & 0xff;
+    if (mask)
+      return i + _tzcnt_u32(mask);
+  }
+  return i + FindNotEqualScalar(container + i, count - i, value);
+}
+
+// FindNotEqualAvx512
+// Entry/Exit: as FindNotEqualScalar
+__attribute__((target("avx512f,bmi")))
+static INDEX FindNotEqualAvx512(const CONTAINER *container, INDEX count, CONTAINER value)
+{
+  const __m512i x = _mm512_set1_epi32((int) value);
+  for (INDEX i = 0; i < count; i += 16) {
+    INDEX left = count - i;
+    __mmask16 live = left >= 16 ? 0xffff : (__mmask16) ((1u << left) - 1);
+    __m512i a = _mm512_maskz_loadu_epi32(live, container + i);
+    __mmask16 ne = _mm512_mask_cmpneq_epu32_mask(live, a, x);
+    if (ne)
+      return i + _tzcnt_u32(ne);
+  }
+  return count;
+}
+
+// CountBeforeSeam
+// Entry: pointer to first element of the window, which is before the seam
+//        number of elements in the window
+//        container[ 0 ]
+// Exit: number of elements in the window before the seam (>= 1)
+static inline UINT CountBeforeSeam(const CONTAINER *base, UINT n, CONTAINER first)
+{
+  UINT count = 0;
+  for (UINT i = 0; i < n; i++)
+    count += base[ i ] >= first;
+  return count;
+}
+
+// Each level of the k-ary search has a window of n elements starting at
+// base, with base known to be before the seam.  Separators are read at
+// base + j * step for j = 0..k-1, step = n / k; the count c of those
+// before the seam places the pivot in the c-th slice, the last slice
+// taking the remainder.  Windows of k elements or fewer are counted
+// directly.
+
+// FindPivotKaryScalar
+// Entry: pointer to container
+//        size of container in elements
+//        separators per level (4, 8 or 16)
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+static UINT FindPivotKaryScalar(const CONTAINER *container, UINT size, UINT ways, UINT *tries)
+{
+  const CONTAINER first = container[ 0 ];
+  const CONTAINER *base = container;
+  UINT n = size;
+  UINT levels = 0;
+  while (n > ways) {
+    UINT step = n / ways;
+    UINT count = 0;
+    for (UINT j = 0; j < ways; j++)
+      count += base[ j * step ] >= first;
+    base += (count - 1) * step;
+    n = count == ways ? n - (ways - 1) * step : step;
+    levels++;
+  }
+  *tries += levels + 2;    // levels, the container[ 0 ] probe and the last window
+  return (UINT) (base - container) + CountBeforeSeam(base, n, first) - 1;
+}
+
+// FindPivotKaryAvx2
+// Separators are fetched with gathers; AVX2 has no unsigned compare, so
+// a >= b is derived from max(a, b) == a.
+// Entry/Exit: as FindPivotKaryScalar
+__attribute__((target("avx2,popcnt")))
+static UINT FindPivotKaryAvx2(const CONTAINER *container, UINT size, UINT ways, UINT *tries)
+{
+  const CONTAINER first = container[ 0 ];
+  const __m128i first4 = _mm_set1_epi32((int) first);
+  const __m256i first8 = _mm256_set1_epi32((int) first);
+  const __m128i lanes4 = _mm_setr_epi32(0, 1, 2, 3);
+  const __m256i lanes8 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const CONTAINER *base = container;
+  UINT n = size;
+  UINT levels = 0;
+  while (n > ways) {
+    UINT step = n / ways;
+    UINT count;
+    if (ways == 4) {
+      __m128i idx = _mm_mullo_epi32(lanes4, _mm_set1_epi32((int) step));
+      __m128i v = _mm_i32gather_epi32((const int *) base, idx, 4);
+      __m128i ge = _mm_cmpeq_epi32(_mm_max_epu32(v, first4), v);
+      count = _mm_popcnt_u32(_mm_movemask_ps(_mm_castsi128_ps(ge)));
+    } else {
+      __m256i vstep = _mm256_set1_epi32((int) step);
+      __m256i idx = _mm256_mullo_epi32(lanes8, vstep);
+      __m256i v = _mm256_i32gather_epi32((const int *) base, idx, 4);
+      __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(v, first8), v);
+      count = _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(ge)));
+      if (ways == 16) {
+        idx = _mm256_add_epi32(idx, _mm256_slli_epi32(vstep, 3));
+        v = _mm256_i32gather_epi32((const int *) base, idx, 4);
+        ge = _mm256_cmpeq_epi32(_mm256_max_epu32(v, first8), v);
+        count += _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(ge)));
+      }
+    }
+    base += (count - 1) * step;
+    n = count == ways ? n - (ways - 1) * step : step;
+    levels++;
+  }
+  *tries += levels + 2;
+  return (UINT) (base - container) + CountBeforeSeam(base, n, first) - 1;
+}
+
+// FindPivotKaryAvx512
+// Sixteen separators fill one register; narrower searches use the AVX2
+// gathers.
+// Entry/Exit: as FindPivotKaryScalar
+__attribute__((target("avx512f,avx2,popcnt")))
+static UINT FindPivotKaryAvx512(const CONTAINER *container, UINT size, UINT ways, UINT *tries)
+{
+  if (ways != 16)
+    return FindPivotKaryAvx2(container, size, ways, tries);
+  const CONTAINER first = container[ 0 ];
+  const __m512i first16 = _mm512_set1_epi32((int) first);
+  const __m512i lanes16 = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const CONTAINER *base = container;
+  UINT n = size;
+  UINT levels = 0;
+  while (n > 16) {
+    UINT step = n >> 4;
+    __m512i idx = _mm512_mullo_epi32(lanes16, _mm512_set1_epi32((int) step));
+    __m512i v = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xffff, idx, base, 4);
+    UINT count = _mm_popcnt_u32(_mm512_cmpge_epu32_mask(v, first16));
+    base += (count - 1) * step;
+    n = count == 16 ? n - 15 * step : step;
+    levels++;
+  }
+  *tries += levels + 2;
+  __mmask16 live = (__mmask16) ((1u << n) - 1);
+  __m512i v = _mm512_maskz_loadu_epi32(live, base);
+  UINT count = _mm_popcnt_u32(_mm512_mask_cmpge_epu32_mask(live, v, first16));
+  return (UINT) (base - container) + count - 1;
+}
+
+// ScanSet
+// The scan implementations for one instruction set
+struct ScanSet {
+  INDEX (*descent)(const CONTAINER *, INDEX);
+  INDEX (*not_equal)(const CONTAINER *, INDEX, CONTAINER);
+  UINT (*kary)(const CONTAINER *, UINT, UINT, UINT *);
+};
+
+// DetectScanIsa
+// Exit: widest scan instruction set supported by this CPU
+ScanIsa DetectScanIsa()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("bmi"))
+    return SCAN_AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+    return SCAN_AVX2;
+  return SCAN_SCALAR;
+}
+
+// ScanFor
+// Entry: scan instruction set
+// Exit: scan implementations
+static ScanSet ScanFor(ScanIsa isa)
+{
+  switch (isa) {
+    case SCAN_AVX512:
+      return { FindDescentAvx512, FindNotEqualAvx512, FindPivotKaryAvx512 };
+    case SCAN_AVX2:
+      return { FindDescentAvx2, FindNotEqualAvx2, FindPivotKaryAvx2 };
+    case SCAN_SCALAR:
+    default:
+      return { FindDescentScalar, FindNotEqualScalar, FindPivotKaryScalar };
+  }
+}
+
+static ScanSet scans = ScanFor(DetectScanIsa());
+
+// SetScanIsa
+// Force the scan implementation (for benchmarking the fallbacks)
+// Entry: scan instruction set
+// Exit: false if the CPU does not support it
+bool SetScanIsa(ScanIsa isa)
+{
+  if (isa > DetectScanIsa())
+    return false;
+  scans = ScanFor(isa);
+  return true;
+}
+
+// FindDescent
+// Entry: pointer to first element of the window
+//        number of adjacent pairs to compare (count + 1 elements are read)
+// Exit: offset of the first descent, count if there is none
+INDEX FindDescent(const CONTAINER *container, INDEX count)
+{
+  return scans.descent(container, count);
+}
+
+// FindNotEqual
+// Entry: pointer to first element
+//        number of elements to compare
+//        value to skip
+// Exit: offset of the first element != value, count if there is none
+INDEX FindNotEqual(const CONTAINER *container, INDEX count, CONTAINER value)
+{
+  return scans.not_equal(container, count, value);
+}
+
+// FindRampPivotKary
+// Search with ways separators per level, taking log_ways(n) dependent
+// steps instead of log2(n).  Needs unique entries, as
+// FindRampPivotBranchless does.
+//
+// The gathers take 32-bit offsets, so windows of 2^31 elements or more
+// are first narrowed with scalar k-ary levels.  The narrowed window
+// starts before the seam, so its own first element serves as
+// container[ 0 ] for the rest of the search.
+// Entry: pointer to container
+//        size of container in elements
+//        separators per level (4, 8 or 16)
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+INDEX FindRampPivotKary(
+    const CONTAINER *container,
+    SIZE size,
+    UINT ways,
+    UINT *tries)
+{
+  assert(ways == 4 || ways == 8 || ways == 16);
+  const CONTAINER first = container[ 0 ];
+  const CONTAINER *base = container;
+  INDEX n = (INDEX) size;
+  while (n > 0x7fffffff) {
+    INDEX step = n / ways;
+    UINT count = 0;
+    for (UINT j = 0; j < ways; j++)
+      count += base[ j * step ] >= first;
+    base += (count - 1) * step;
+    n = count == ways ? n - (ways - 1) * step : step;
+    (*tries)++;
+  }
+  return (INDEX) (base - container) + scans.kary(base, (UINT) n, ways, tries);
+}
+
+// FindRampPivotHybrid
+// Bisect with conditional moves as FindRampPivotBranchless does until the
+// window is at most SCAN_WINDOW elements, then locate the descent inside
+// the window with one vector scan.
+// Entry: pointer to container
+//        size of container in elements
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+INDEX FindRampPivotHybrid(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  const CONTAINER first = container[ 0 ];
+  const CONTAINER *base = container;
+  INDEX n = (INDEX) size;
+  UINT steps = 0;
+  while (n > SCAN_WINDOW) {
+    INDEX half = n >> 1;
+    base = (base[ half ] >= first) ? base + half : base;
+    n -= half;
+    steps++;
+  }
+  *tries += steps + 2;     // halvings, the container[ 0 ] probe and the scan
+  return (INDEX) (base - container) + FindDescent(base, n - 1);
+}
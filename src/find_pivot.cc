@@ -23,14 +23,16 @@
 #include <ctime>
 #include <cassert>
 #include <vector>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <sys/mman.h>
+#include <unistd.h>
 
-// Definitions
-typedef __int32_t SIZE;
-typedef __uint32_t UINT;
-typedef UINT CONTAINER;
-
-// Constants
-const unsigned INCREMENT_BOUND = 4;
+#include "find_pivot.h"
+#include "mapped_ramp.h"
+#include "record_search.h"
+#include "sidecar.h"
 
 // FreeContainer
 // Deallocate container resources
@@ -38,17 +40,73 @@ const unsigned INCREMENT_BOUND = 4;
 void FreeContainer(const CONTAINER *container)
 {
 
-    delete container;
+    delete[] container;
 
 }
 
 // AllocContainer
 // Allocate container resources
 // Entry: size of container
-// Exit: pointer to container
+// Exit: pointer to container, nullptr if memory is short
 CONTAINER *AllocContainer(SIZE size)
 {
-  return new CONTAINER[ size ];
+  return new (std::nothrow) CONTAINER[ size ];
+}
+
+// MirroredSize
+// Entry: size of container in elements
+// Exit: smallest size not below it that AllocMirroredContainer accepts, a
+//       whole number of pages
+SIZE MirroredSize(SIZE size)
+{
+  const SIZE per_page = (SIZE) sysconf(_SC_PAGESIZE) / (SIZE) sizeof(CONTAINER);
+  return (size + per_page - 1) / per_page * per_page;
+}
+
+// AllocMirroredContainer
+// Allocate a container whose memory is mapped twice back to back, so
+// container[ size + i ] is container[ i ].  For any ramp start s,
+// container + s up to container + s + size is then the whole ramp in
+// logical order as one contiguous range: no copy and no wrap.  The
+// container must be freed with FreeMirroredContainer.
+// Entry: size of container in elements, a multiple of the page size
+//        (see MirroredSize)
+// Exit: pointer to container, nullptr on error
+CONTAINER *AllocMirroredContainer(SIZE size)
+{
+  const size_t bytes = (size_t) size * sizeof(CONTAINER);
+  if (size < 1 || MirroredSize(size) != size)
+    return nullptr;
+  int fd = memfd_create("findramp", MFD_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+  if (ftruncate(fd, (off_t) bytes)) {
+    close(fd);
+    return nullptr;
+  }
+
+  // Reserve both halves, then map the file over each
+  unsigned char *base = static_cast<unsigned char *>(
+      mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  bool ok = base != MAP_FAILED &&
+    mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+    mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+  close(fd);
+  if (!ok) {
+    if (base != MAP_FAILED)
+      munmap(base, 2 * bytes);
+    return nullptr;
+  }
+  return reinterpret_cast<CONTAINER *>(base);
+}
+
+// FreeMirroredContainer
+// Entry: pointer to container from AllocMirroredContainer
+//        size of container in elements
+void FreeMirroredContainer(const CONTAINER *container, SIZE size)
+{
+  if (container)
+    munmap((void *) container, 2 * (size_t) size * sizeof(CONTAINER));
 }
 
 // PrintContainer
@@ -57,7 +115,7 @@ CONTAINER *AllocContainer(SIZE size)
 //        size of container
 void PrintContainer(CONTAINER *container, SIZE size)
 {
-  for (auto i = 0; i < size; i++)
+  for (SIZE i = 0; i < size; i++)
     std::cout << container[ i ] << " ";
   std::cout << std::endl;
 }
@@ -67,10 +125,12 @@ void PrintContainer(CONTAINER *container, SIZE size)
 //        size of container
 //        start index in container
 //        true == allow duplicates, false == increment by one
-void GenerateRamp(CONTAINER *container, SIZE size, UINT startIdx, bool dupes)
+//        value at the start index; the ramp wraps past 2^32 when it is
+//        high enough, as sequence numbers do
+void GenerateRamp(CONTAINER *container, SIZE size, INDEX startIdx, bool dupes, CONTAINER base)
 {
-  UINT i = startIdx;
-  CONTAINER j = 0;
+  INDEX i = startIdx;
+  CONTAINER j = base;
   do {
     container[ i ] = j;
     if (dupes) {
@@ -79,7 +139,7 @@ void GenerateRamp(CONTAINER *container, SIZE size, UINT startIdx, bool dupes)
       j += 1;
     }
     if (!dupes) {
-      if (!j) {
+      if (j == base) {
         j++;
       }
     }
@@ -88,6 +148,125 @@ void GenerateRamp(CONTAINER *container, SIZE size, UINT startIdx, bool dupes)
   //PrintContainer(container, size);
 }
 
+// RampStep
+// Stateless pseudo-random step for GenerateRampParallel, so every thread
+// can regenerate any step without sharing generator state (splitmix64)
+// Entry: seed
+//        step number
+// Exit: step in [0, INCREMENT_BOUND)
+static inline UINT RampStep(uint64_t seed, uint64_t n)
+{
+  uint64_t z = seed + n * 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return (UINT) ((z ^ (z >> 31)) % INCREMENT_BOUND);
+}
+
+// GenerateRampParallel
+// Generate a ramp as GenerateRamp does, splitting the logical order into
+// one slice per thread.  A large container is allocated untouched, so
+// each page is first written, and on a NUMA machine placed, by the
+// thread that generates it.
+//
+// The values are a function of the logical offset from startIdx rather
+// than of a running sequence: offset >> shift without duplicates, and
+// with duplicates a sum of random steps in [0, INCREMENT_BOUND) taken
+// every 1 << shift offsets, each slice first summing its steps so it
+// knows where to begin.  shift is 0 until the values would overflow 32
+// bits; past that (beyond 4G elements without duplicates) every value
+// repeats 1 << shift times, and only the duplicate-correct engines
+// apply.
+// Entry: pointer to container
+//        size of container
+//        start index in container
+//        true == allow duplicates, false == increment by one
+//        value at the start index
+//        number of threads (0 for one per CPU)
+void GenerateRampParallel(
+    CONTAINER *container,
+    SIZE size,
+    INDEX startIdx,
+    bool dupes,
+    CONTAINER base,
+    UINT threads)
+{
+  const INDEX n = (INDEX) size;
+  const uint64_t max_step = dupes ? INCREMENT_BOUND - 1 : 1;
+  const uint64_t seed = ((uint64_t) rand() << 31) ^ (uint64_t) rand();
+  UINT shift = 0;
+  while (((n - 1) >> shift) * max_step > 0xffffffffull)
+    shift++;
+
+  if (!threads)
+    threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  // Slices hold whole groups of 1 << shift offsets
+  INDEX groups = ((n - 1) >> shift) + 1;
+  INDEX per = (groups + threads - 1) / threads;
+  std::vector<CONTAINER> begin(threads, base);
+  if (dupes) {
+    std::vector<CONTAINER> sums(threads, 0);
+    auto sum = [&](UINT t) {
+      CONTAINER total = 0;
+      for (INDEX g = t * per; g < (t + 1) * per && g < groups; g++)
+        total += g ? RampStep(seed, g) : 0;
+      sums[ t ] = total;
+    };
+    std::vector<std::thread> pool;
+    for (UINT t = 1; t < threads; t++)
+      pool.emplace_back(sum, t);
+    sum(0);
+    for (std::thread &thread : pool)
+      thread.join();
+    for (UINT t = 1; t < threads; t++)
+      begin[ t ] = begin[ t - 1 ] + sums[ t - 1 ];
+  }
+
+  auto fill = [&](UINT t) {
+    INDEX lo = std::min(n, (t * per) << shift);
+    INDEX hi = std::min(n, ((t + 1) * per) << shift);
+    CONTAINER value = begin[ t ];
+    const INDEX mask = ((INDEX) 1 << shift) - 1;
+    INDEX i = (startIdx + lo) % n;
+    for (INDEX offset = lo; offset < hi; offset++) {
+      if (dupes) {
+        if (offset && !(offset & mask))
+          value += RampStep(seed, offset >> shift);
+      } else {
+        value = base + (CONTAINER) (offset >> shift);
+      }
+      container[ i ] = value;
+      if (++i == n)
+        i = 0;
+    }
+  };
+  std::vector<std::thread> pool;
+  for (UINT t = 1; t < threads; t++)
+    pool.emplace_back(fill, t);
+  fill(0);
+  for (std::thread &thread : pool)
+    thread.join();
+}
+
+// GeneratePlateauRamp
+// Generate a ramp whose steps repeat the previous value with the given
+// probability, producing plateaus of geometrically distributed length.
+// Entry: pointer to container
+//        size of container
+//        start index in container
+//        probability (0.0 - 1.0) that an element repeats its predecessor
+void GeneratePlateauRamp(CONTAINER *container, SIZE size, INDEX startIdx, double density)
+{
+  const UINT threshold = (UINT) (density * RAND_MAX);
+  INDEX i = startIdx % size;
+  CONTAINER j = 0;
+  do {
+    container[ i ] = j;
+    if ((UINT) rand() >= threshold)
+      j++;
+    i = (i + 1) % size;
+  } while (i != startIdx % size);
+}
+
 // FindRampPivot
 // Find the beginning of the ramp, or "pivot" within a rotated sorted table.
 // Takes the high and low indexes, calculates a midpoint, and recurses into itself
@@ -98,10 +277,10 @@ void GenerateRamp(CONTAINER *container, SIZE size, UINT startIdx, bool dupes)
 //        pointer to tries (for complexity analyis)
 // Exit: pivot
 // NOTE: Recursive function
-UINT FindRampPivot(
+INDEX FindRampPivot(
     const CONTAINER *container,
-    UINT left_idx,
-    UINT right_idx,
+    INDEX left_idx,
+    INDEX right_idx,
     UINT *tries)
 {
   (*tries)++;     // bookkeeping/analysis
@@ -113,7 +292,7 @@ UINT FindRampPivot(
 
   // Zero in on the pivot point based on the relative quantities
   // at the different indexes.
-  UINT mid_idx = (left_idx + right_idx) >> 1;
+  INDEX mid_idx = (left_idx + right_idx) >> 1;
   if (mid_idx < right_idx && container[ mid_idx ] > container[ mid_idx + 1 ])
     return mid_idx;
   if (mid_idx > left_idx && container[ mid_idx ] < container[ mid_idx - 1 ])
@@ -124,34 +303,220 @@ UINT FindRampPivot(
   return FindRampPivot(container, mid_idx + 1, right_idx, tries);
 }
 
+// FindRampPivotBranchless
+// Find the pivot with a fixed number of halvings and no data-dependent branches.
+// See ramp::FindPivot.
+// Entry: pointer to container
+//        size of container in elements
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+INDEX FindRampPivotBranchless(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  INDEX steps = 0;
+  INDEX pivot = ramp::FindPivot<CONTAINER, INDEX>(container, size, std::less<CONTAINER>(), &steps);
+  *tries += (UINT) steps;
+  return pivot;
+}
+
+// FindRunEndLinear
+// Scan forward, wrapping at the end of the buffer, to the last element of
+// the run of entries equal to container[ idx ].  See ramp::FindRunEndLinear.
+// Entry: pointer to container
+//        size of container in elements
+//        index of an element in the run
+// Exit: index of the last element of the run; size - 1 if every element
+//       is equal
+INDEX FindRunEndLinear(const CONTAINER *container, SIZE size, INDEX idx)
+{
+  return ramp::FindRunEndLinear<CONTAINER, INDEX>(container, size, idx);
+}
+
+// FindRunEnd
+// Find the last element of the run of entries equal to container[ idx ]
+// in O(log k) probes for a run of length k.  See ramp::FindRunEnd.
+// Entry: pointer to container
+//        size of container in elements
+//        index of an element in the run
+// Exit: index of the last element of the run
+INDEX FindRunEnd(const CONTAINER *container, SIZE size, INDEX idx)
+{
+  return ramp::FindRunEnd<CONTAINER, INDEX>(container, size, idx);
+}
+
+// PivotToStart
+// Step from the pivot over any repeated entries to the ramp start
+// Entry: pointer to container
+//        size of container in elements
+//        pivot
+// Exit: ramp start, ~0 if the pivot is invalid
+INDEX PivotToStart(const CONTAINER *container, SIZE size, INDEX pivot)
+{
+  if ((INDEX) ~0 == pivot)
+    return pivot;
+
+  // EDGE CASE: Skip any repeated entries
+  return (FindRunEnd(container, size, pivot) + 1) % size;
+}
+
+// FindRampPivotPlateau
+// Duplicate-correct pivot search.  An ambiguous plateau, where both window
+// ends and the midpoint are equal, is crossed with a vector scan instead
+// of guessed.  See ramp::FindPivotPlateau.
+// Entry: pointer to container
+//        size of container in elements
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+INDEX FindRampPivotPlateau(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  INDEX steps = 0;
+  INDEX pivot = ramp::FindPivotPlateau<CONTAINER, INDEX>(container, size, std::less<CONTAINER>(), &steps);
+  *tries += (UINT) steps;
+  return pivot;
+}
+
+// FindRampPivotDense
+// Constant-time pivot for dense ramps whose values step by exactly one
+// from 0, as GenerateRamp makes without duplicates.  The start is
+// (size - container[ 0 ]) % size, confirmed with two probes; anything else
+// falls back to FindRampPivotPlateau.  See ramp::FindPivotDense.
+// Entry: pointer to container
+//        size of container in elements
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+INDEX FindRampPivotDense(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  INDEX steps = 0;
+  INDEX pivot = ramp::FindPivotDense<CONTAINER, INDEX>(container, size, 0, &steps);
+  *tries += (UINT) steps;
+  return pivot;
+}
+
 // FindRampStart
 // Find the transition between 0 and n (ramp start)
 // Entry: pointer to container
 //        size of container in elements
 //        pointer to tries count (for complexity analysis)
-UINT FindRampStart(
+//        search engine
+INDEX FindRampStart(
     CONTAINER *container,
     SIZE size,
-    UINT *tries
+    UINT *tries,
+    PivotEngine engine
   )
 {
   assert(size);
-  UINT pivot;
+  INDEX pivot;
+
+  if (engine == ENGINE_SERIAL)
+    return FindRampStartSerial(container, size, tries);
 
   // First, check for edge case where the pivot seam matches the bounds of the array
-  // (i.e. array is not rotated)
-  if (!container[ 0 ])
+  // (i.e. array is not rotated).  Only a rotation puts a larger value first.
+  if (container[ 0 ] < container[ size - 1 ])
     return 0;
 
-  pivot = FindRampPivot(container, 0, size - 1, tries);
+  switch (engine) {
+    case ENGINE_BRANCHLESS:
+      pivot = FindRampPivotBranchless(container, size, tries);
+      break;
+    case ENGINE_HYBRID:
+      pivot = FindRampPivotHybrid(container, size, tries);
+      break;
+    case ENGINE_PLATEAU:
+      pivot = FindRampPivotPlateau(container, size, tries);
+      break;
+    case ENGINE_DENSE:
+      pivot = FindRampPivotDense(container, size, tries);
+      break;
+    case ENGINE_KARY:
+      pivot = FindRampPivotKary(container, size, KARY_WAYS, tries);
+      break;
+    case ENGINE_RECURSIVE:
+    default:
+      pivot = FindRampPivot(container, 0, size - 1, tries);
+      break;
+  }
 
-  // EDGE CASE: Skip any repeated entries
-  while (container[ (pivot + 1) % size ] == container[ pivot ])
-    pivot = (pivot + 1) % size;
+  return PivotToStart(container, size, pivot);
+}
 
-  if ((UINT) ~0 != pivot)
-    pivot = (pivot + 1) % size;
-  return pivot;
+// FindRampStartFromHint
+// Find the ramp start of a buffer that has rotated a little since an
+// earlier lookup, galloping out from that lookup's start in O(log k)
+// probes for a move of k places.  Needs unique entries.
+// See ramp::FindPivotFromHint.
+// Entry: pointer to container
+//        size of container in elements
+//        ramp start found by the earlier lookup
+//        pointer to tries count (for complexity analysis)
+// Exit: ramp start
+INDEX FindRampStartFromHint(
+    const CONTAINER *container,
+    SIZE size,
+    INDEX hint,
+    UINT *tries)
+{
+  assert(size);
+  INDEX steps = 0;
+  INDEX start = ramp::FindStartFromHint<CONTAINER, INDEX>(container, size, hint, std::less<CONTAINER>(), &steps);
+  *tries += (UINT) steps;
+  return start;
+}
+
+// FindRampStartSerial
+// Find the ramp start of a buffer of sequence numbers that may straddle
+// the wrap from 2^32 - 1 to 0, ordering them as RFC 1982 serial numbers.
+// The live values must span less than 2^31.  Repeated entries are
+// allowed.  See ramp::SerialLess.
+// Entry: pointer to container
+//        size of container in elements
+//        pointer to tries count (for complexity analysis)
+// Exit: index of the oldest element
+INDEX FindRampStartSerial(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  assert(size);
+  ramp::SerialLess<CONTAINER> comp;
+  if (comp(container[ 0 ], container[ size - 1 ]))
+    return 0;
+  INDEX steps = 0;
+  INDEX pivot = ramp::FindPivotPlateau<CONTAINER, INDEX>(container, size, comp, &steps);
+  *tries += (UINT) steps;
+  return ramp::PivotToStart<CONTAINER, INDEX>(container, size, pivot, comp);
+}
+
+// FindRampStartStrided
+// Find the ramp start of fixed-size records ordered by a CONTAINER key
+// field.  Needs unique keys.  See ramp::FindStartStrided.
+// Entry: pointer to the first record
+//        number of records
+//        bytes from one record to the next
+//        byte offset of the key in a record
+//        pointer to tries count (for complexity analysis)
+// Exit: index of the record with the smallest key
+INDEX FindRampStartStrided(
+    const void *records,
+    SIZE size,
+    UINT stride,
+    UINT keyOffset,
+    UINT *tries)
+{
+  assert(size);
+  INDEX steps = 0;
+  INDEX start = ramp::FindStartStrided<CONTAINER, INDEX>(records, size, stride, keyOffset, std::less<CONTAINER>(), &steps);
+  *tries += (UINT) steps;
+  return start;
 }
 
 void PrintUsage()
@@ -159,9 +524,95 @@ void PrintUsage()
   std::cout << "FindRamp" << std::endl;
   std::cout << "Copyright (C) 2018 Gregory Hedger" << std::endl;
   std::cout << "Usage:" << std::endl;
-  std::cout << "\tfindramp <container_size> <#_of_iterations>" << std::endl;
+  std::cout << "\tfindramp [-d] [-e engine] [-p] [-w] <container_size> <#_of_iterations>" << std::endl;
+  std::cout << "\tfindramp -f <ramp_file>" << std::endl;
+  std::cout << "\tfindramp -s <directory> [-j threads]" << std::endl;
+  std::cout << "\tfindramp bench <name>" << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "\t-d\t\tallow duplicate entries in the ramp" << std::endl;
+  std::cout << "\t-e engine\trecursive (default), branchless, hybrid," << std::endl;
+  std::cout << "\t\t\tplateau, dense, kary or serial" << std::endl;
+  std::cout << "\t-f file\t\tsearch a mapped file of CONTAINER values instead" << std::endl;
+  std::cout << "\t-p\t\tprint the container after the last iteration" << std::endl;
+  std::cout << "\t-w\t\tstart ramps just below 2^32 so they wrap (use -e serial)" << std::endl;
+  std::cout << "\t-s dir\t\twrite a .pivot sidecar for every ramp file in dir" << std::endl;
+  std::cout << "\t-j threads\tthreads for -s (default one per CPU)" << std::endl;
+  std::cout << "Benchmarks:" << std::endl;
+  PrintBenchmarks();
   std::cout << "Example:" << std::endl;
   std::cout << "\tfindramp 250 10000" << std::endl;
+  std::cout << "\tfindramp bench engines" << std::endl;
+}
+
+// ParseEngine
+// Map an engine name from the command line to a PivotEngine
+// Entry: engine name
+//        pointer to engine (out)
+// Exit: true if the name is recognized
+bool ParseEngine(const char *name, PivotEngine *engine)
+{
+  if (!strcmp(name, "recursive")) {
+    *engine = ENGINE_RECURSIVE;
+  } else if (!strcmp(name, "branchless")) {
+    *engine = ENGINE_BRANCHLESS;
+  } else if (!strcmp(name, "hybrid")) {
+    *engine = ENGINE_HYBRID;
+  } else if (!strcmp(name, "plateau")) {
+    *engine = ENGINE_PLATEAU;
+  } else if (!strcmp(name, "dense")) {
+    *engine = ENGINE_DENSE;
+  } else if (!strcmp(name, "kary")) {
+    *engine = ENGINE_KARY;
+  } else if (!strcmp(name, "serial")) {
+    *engine = ENGINE_SERIAL;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// SearchRampFile
+// Map a ramp file, find its start with the page-aligned search and report
+// the pages faulted in and bytes read from storage
+// Entry: path
+// Exit: 0 on success
+int SearchRampFile(const char *path)
+{
+  MappedRamp ramp;
+  if (!MapRamp(path, &ramp)) {
+    std::cout << "Cannot map " << path << std::endl;
+    return -1;
+  }
+  PageStats before, after;
+  ReadPageStats(&before);
+  UINT tries = 0;
+  INDEX idx = PivotToStart(ramp.container, ramp.size,
+      FindRampPivotPaged(ramp.container, ramp.size, &tries));
+  ReadPageStats(&after);
+
+  std::cout << "SIZE: " << ramp.size << std::endl;
+  std::cout << "START: " << idx << " (" << ramp.container[ idx ] << ")" << std::endl;
+  std::cout << "TRIES: " << tries << std::endl;
+  std::cout << "FAULTS: " << after.minor_faults - before.minor_faults << " minor, " <<
+    after.major_faults - before.major_faults << " major" << std::endl;
+  std::cout << "READ BYTES: " << after.read_bytes - before.read_bytes << std::endl;
+  UnmapRamp(&ramp);
+  return 0;
+}
+
+// BuildSidecarDirectory
+// Write sidecars for a directory of ramp files and report the counts
+// Entry: directory
+//        number of threads (0 for one per CPU)
+// Exit: 0 if every file succeeded
+int BuildSidecarDirectory(const char *dir, UINT threads)
+{
+  UINT failed;
+  clock_t ticks = clock();
+  UINT written = BuildSidecars(dir, threads, &failed);
+  std::cout << "SIDECARS: " << written << " written, " << failed << " failed" << std::endl;
+  std::cout << "CPU SECONDS: " << (double) (clock() - ticks) / CLOCKS_PER_SEC << std::endl;
+  return failed ? -1 : 0;
 }
 
 int main(int argc, char *argv[])
@@ -170,20 +621,56 @@ int main(int argc, char *argv[])
   srand(( UINT) time(nullptr));
   //srand(428);
 
+  if (argc > 2 && !strcmp(argv[1], "bench")) {
+    return RunBenchmark(argv[2], argc - 3, argv + 3);
+  }
+
   // grab params
   SIZE container_size;
-  UINT iteration_tot;
-  bool allowDuplicates;
+  uint64_t iteration_tot;
+  bool allowDuplicates = false;
   bool printContainer = false;
-  if (argc > 2) {
-    strtol(argv[1], reinterpret_cast<char **>(&container_size), 10);
-    strtol(argv[1], reinterpret_cast<char **>(&iteration_tot), 10);
-    //sscanf(argv[2], "%d", &iteration_tot);
-
-    //sscanf(argv[1], "%d", &container_size);
-    //sscanf(argv[2], "%d", &iteration_tot);
-    allowDuplicates = false;
-    if (argc > 3) {
+  bool wrapValues = false;
+  PivotEngine engine = ENGINE_RECURSIVE;
+  const char *sidecarDir = nullptr;
+  UINT threads = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "de:f:j:ps:w")) != -1) {
+    switch (opt) {
+      case 'e':
+        if (!ParseEngine(optarg, &engine)) {
+          PrintUsage();
+          return -1;
+        }
+        break;
+      case 'd':
+        allowDuplicates = true;
+        break;
+      case 'f':
+        return SearchRampFile(optarg);
+      case 'j':
+        threads = (UINT) strtoul(optarg, nullptr, 10);
+        break;
+      case 's':
+        sidecarDir = optarg;
+        break;
+      case 'p':
+        printContainer = true;
+        break;
+      case 'w':
+        wrapValues = true;
+        break;
+      default:
+        PrintUsage();
+        return -1;
+    }
+  }
+  if (sidecarDir)
+    return BuildSidecarDirectory(sidecarDir, threads);
+  if (argc - optind > 1) {
+    container_size = (SIZE) strtoll(argv[optind], nullptr, 10);
+    iteration_tot = (uint64_t) strtoull(argv[optind + 1], nullptr, 10);
+    if (argc - optind > 2) {
       printContainer = true;
     }
   } else {
@@ -191,47 +678,51 @@ int main(int argc, char *argv[])
     return -1;
   }
 
-  if (
-      container_size > 10000000 || !container_size ||
-      iteration_tot > 10000000 || !iteration_tot ||
-      argc < 2
-  ) {
+  if (container_size < 1 || !iteration_tot) {
     PrintUsage();
     return -1;
   }
 
   // Allocate and generate container
   CONTAINER *container = AllocContainer(container_size);
+  if (!container) {
+    std::cout << "Cannot allocate " << container_size << " elements." << std::endl;
+    return -1;
+  }
 
-  // Perform test
-  UINT tries_accum = 0;
-  std::vector<UINT> tries_vect;
-  for (UINT i = 0; i < iteration_tot; i++)
+  // Perform test.  Counters are 64-bit: long runs overflow 32 bits of tries.
+  uint64_t tries_accum = 0;
+  uint64_t tries_squares = 0;
+  for (uint64_t i = 0; i < iteration_tot; i++)
   {
     //srand(i);
-    UINT startIdx = rand() % container_size;
-    GenerateRamp(container, container_size, startIdx, allowDuplicates);
+    INDEX startIdx = (((INDEX) rand() << 31) ^ (INDEX) rand()) % container_size;
+    CONTAINER base = wrapValues ? (CONTAINER) 0 - 1 - rand() % container_size : 0;
+    if (container_size >= PARALLEL_GENERATE)
+      GenerateRampParallel(container, container_size, startIdx, allowDuplicates, base);
+    else
+      GenerateRamp(container, container_size, startIdx, allowDuplicates, base);
     UINT tries = 0;
-    UINT idx = FindRampStart(
+    INDEX idx = FindRampStart(
         container,
         container_size,
-        &tries);
-    if ((UINT) ~0 == idx) {
+        &tries,
+        engine);
+    if ((INDEX) ~0 == idx) {
       std::cout << "Error in search parameters." << std::endl;
     }
-    // In this test, it should always find 0.
+    // In this test, it should always find base (0 unless -w).
     // If it does not, that is noteworthy and indicates a bug
-    else if (container[ idx ]) {
+    else if (container[ idx ] != base) {
       std::cout << "TEST " << i << " Error finding element. idx 0:" << container[0] << " idx:" << idx << std::endl;
       std::cout << "Reported: " << idx << ":" << container[idx] << "  ";
     }
-    if ((UINT) ~0 == idx || container[ idx ]) {
-      std::cout << "TEST " << i << ": Actual: " << (container_size - container[0]) % container_size << ":" <<
-        container[ container_size - container[0] ] << std::endl;
+    if ((INDEX) ~0 == idx || container[ idx ] != base) {
+      std::cout << "TEST " << i << ": Actual: " << startIdx << ":" << container[ startIdx ] << std::endl;
     }
 
     tries_accum += tries;
-    tries_vect.push_back(tries);
+    tries_squares += (uint64_t) tries * tries;
   }
 
   // Calculate mean (mu)
@@ -239,13 +730,8 @@ int main(int argc, char *argv[])
   double mu = (double) tries_accum / (double) iteration_tot;
 
   // Calculate std deviation (sigma)
-  double sigma_accum = 0.0;
-  while (!tries_vect.empty()) {
-    UINT compVal =tries_vect.back();
-    tries_vect.pop_back();
-    sigma_accum += pow(( (double) compVal - mu), 2);
-  }
-  sigma = sqrt(sigma_accum / iteration_tot);
+  double variance = (double) tries_squares / (double) iteration_tot - mu * mu;
+  sigma = sqrt(variance > 0.0 ? variance : 0.0);
 
   std::cout << "TRIES MU: " << mu << std::endl;
   std::cout << "TRIES SIGMA: " << sigma << std::endl;
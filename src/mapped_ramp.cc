@@ -0,0 +1,155 @@
+// Mapped ramp files and the page-aligned pivot search.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_ramp.h"
+
+// MapRamp
+// Map a file of native-endian CONTAINER values read-only
+// Entry: path
+//        pointer to ramp (out)
+//        true to advise random access (no readahead)
+// Exit: false if the file cannot be mapped or holds no whole element
+bool MapRamp(const char *path, MappedRamp *ramp, bool random)
+{
+  struct stat st;
+  ramp->fd = open(path, O_RDONLY);
+  if (ramp->fd < 0)
+    return false;
+  if (fstat(ramp->fd, &st) || st.st_size < (off_t) sizeof(CONTAINER)) {
+    close(ramp->fd);
+    return false;
+  }
+  ramp->bytes = (size_t) st.st_size;
+  ramp->size = (SIZE) (ramp->bytes / sizeof(CONTAINER));
+  void *addr = mmap(nullptr, ramp->bytes, PROT_READ, MAP_SHARED, ramp->fd, 0);
+  if (addr == MAP_FAILED) {
+    close(ramp->fd);
+    return false;
+  }
+  if (random)
+    madvise(addr, ramp->bytes, MADV_RANDOM);
+  ramp->container = static_cast<const CONTAINER *>(addr);
+  return true;
+}
+
+// UnmapRamp
+// Entry: pointer to ramp
+void UnmapRamp(MappedRamp *ramp)
+{
+  munmap((void *) ramp->container, ramp->bytes);
+  close(ramp->fd);
+  ramp->container = nullptr;
+}
+
+// DropRampPages
+// Unmap the ramp's pages from this process and evict them from the page
+// cache, so the next lookup starts from storage
+// Entry: pointer to ramp
+void DropRampPages(const MappedRamp *ramp)
+{
+  madvise((void *) ramp->container, ramp->bytes, MADV_DONTNEED);
+  posix_fadvise(ramp->fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+// WriteRampFile
+// Write a rotated ramp of unique values, as GenerateRamp makes, to a file
+// Entry: path
+//        size in elements
+//        start index
+// Exit: false on error
+bool WriteRampFile(const char *path, SIZE size, INDEX startIdx)
+{
+  const SIZE CHUNK = 1 << 16;
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+  std::vector<CONTAINER> chunk(CHUNK);
+  bool ok = true;
+  for (SIZE i = 0; ok && i < size; i += CHUNK) {
+    SIZE count = size - i < CHUNK ? size - i : CHUNK;
+    for (SIZE j = 0; j < count; j++)
+      chunk[ j ] = (CONTAINER) (((INDEX) (i + j) + size - startIdx) % size);
+    ok = fwrite(chunk.data(), sizeof(CONTAINER), count, file) == (size_t) count;
+  }
+  // Written back so the pages can be dropped from the page cache
+  ok = ok && !fflush(file) && !fsync(fileno(file));
+  return fclose(file) == 0 && ok;
+}
+
+// FindRampPivotPaged
+// Bisect over the first element of each page, then inside the one page
+// that holds the pivot.  Every level reads one page not read before, and
+// the page search reads only the page already found, so a lookup touches
+// ceil(log2 pages) + 1 pages.
+// Entry: pointer to container, page aligned
+//        size of container in elements
+//        pointer to tries (for complexity analyis)
+// Exit: pivot
+INDEX FindRampPivotPaged(
+    const CONTAINER *container,
+    SIZE size,
+    UINT *tries)
+{
+  static const INDEX per_page = (INDEX) sysconf(_SC_PAGESIZE) / sizeof(CONTAINER);
+  const CONTAINER first = container[ 0 ];
+  UINT steps = 0;
+
+  // Last page whose first element is before the seam
+  INDEX page = 0;
+  INDEX n = ((INDEX) size + per_page - 1) / per_page;
+  while (n > 1) {
+    INDEX half = n >> 1;
+    page = (container[ (page + half) * per_page ] >= first) ? page + half : page;
+    n -= half;
+    steps++;
+  }
+
+  const CONTAINER *base = container + page * per_page;
+  n = (INDEX) size - page * per_page;
+  n = n < per_page ? n : per_page;
+  while (n > 1) {
+    INDEX half = n >> 1;
+    base = (base[ half ] >= first) ? base + half : base;
+    n -= half;
+    steps++;
+  }
+  *tries += steps + 1;
+  return (INDEX) (base - container);
+}
+
+// ReadPageStats
+// Entry: pointer to stats (out)
+void ReadPageStats(PageStats *stats)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  stats->minor_faults = usage.ru_minflt;
+  stats->major_faults = usage.ru_majflt;
+  stats->read_bytes = 0;
+
+  // Read with a stack buffer: heap allocation here would fault pages in
+  // and count against the lookup being measured
+  int fd = open("/proc/self/io", O_RDONLY);
+  if (fd < 0)
+    return;
+  char text[ 512 ];
+  ssize_t len = read(fd, text, sizeof(text) - 1);
+  close(fd);
+  if (len <= 0)
+    return;
+  text[ len ] = 0;
+  const char *field = strstr(text, "\nread_bytes:");
+  if (field)
+    stats->read_bytes = strtoull(field + 12, nullptr, 10);
+}
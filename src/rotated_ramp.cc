@@ -0,0 +1,56 @@
+// RotatedRamp ring buffer.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <new>
+
+#include "rotated_ramp.h"
+
+// RotatedRamp
+// Entry: capacity in elements (> 0)
+// Exit: throws std::bad_alloc if the container cannot be allocated
+RotatedRamp::RotatedRamp(SIZE capacity)
+  : container_(AllocContainer(capacity)),
+    capacity_(capacity),
+    size_(0),
+    start_(0),
+    tail_(0)
+{
+  assert(capacity > 0);
+  if (!container_)
+    throw std::bad_alloc();
+}
+
+RotatedRamp::~RotatedRamp()
+{
+  FreeContainer(container_);
+}
+
+// Recover
+// Rebuild the start of a full buffer whose contents were written through
+// Data(), with the pivot search.  Values need not start from 0.
+// Entry: true if the buffer may hold repeated values
+//        pointer to tries (may be nullptr)
+// Exit: ramp start
+INDEX RotatedRamp::Recover(bool dupes, UINT *tries)
+{
+  INDEX steps = 0;
+  size_ = capacity_;
+  if (dupes)
+    start_ = ramp::FindStartDuplicates<CONTAINER, INDEX>(container_, capacity_, std::less<CONTAINER>(), &steps);
+  else
+    start_ = ramp::FindStart<CONTAINER, INDEX>(container_, capacity_, std::less<CONTAINER>(), &steps);
+  if (tries)
+    *tries += (UINT) steps;
+  tail_ = start_;
+  return start_;
+}
+
+// Clear
+// Empty the buffer; the next push is written to Data()[ 0 ]
+void RotatedRamp::Clear()
+{
+  size_ = 0;
+  start_ = 0;
+  tail_ = 0;
+}
@@ -0,0 +1,140 @@
+// Segment files of a circular log and the oldest-record search.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "segment_log.h"
+
+// OpenSegmentLog
+// Open the segment files of a log, each a file of native-endian
+// CONTAINER records
+// Entry: paths in write order
+//        pointer to log (out)
+// Exit: false if a segment cannot be opened or holds no whole record
+bool OpenSegmentLog(const std::vector<std::string> &paths, SegmentLog *log)
+{
+  log->fds.clear();
+  log->sizes.clear();
+  for (const std::string &path : paths) {
+    struct stat st;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      break;
+    log->fds.push_back(fd);
+    if (fstat(fd, &st) || st.st_size < (off_t) sizeof(CONTAINER))
+      break;
+    log->sizes.push_back((SIZE) ((size_t) st.st_size / sizeof(CONTAINER)));
+  }
+  if (log->sizes.size() == paths.size() && !paths.empty())
+    return true;
+  CloseSegmentLog(log);
+  return false;
+}
+
+// CloseSegmentLog
+// Entry: pointer to log
+void CloseSegmentLog(SegmentLog *log)
+{
+  for (int fd : log->fds)
+    close(fd);
+  log->fds.clear();
+  log->sizes.clear();
+}
+
+// ReadLogRecord
+// Entry: log
+//        position
+//        pointer to value (out)
+// Exit: false on a failed read
+bool ReadLogRecord(const SegmentLog *log, LogPosition pos, CONTAINER *value)
+{
+  return pread(log->fds[ pos.segment ], value, sizeof(*value),
+      (off_t) pos.record * sizeof(CONTAINER)) == (ssize_t) sizeof(*value);
+}
+
+// WriteSegmentLog
+// Write a rotated ramp of unique values, as GenerateRamp makes, across
+// segment files of equal size
+// Entry: paths in write order
+//        records per segment
+//        logical start index over all segments
+// Exit: false on error
+bool WriteSegmentLog(const std::vector<std::string> &paths, SIZE segmentSize, INDEX startIdx)
+{
+  const INDEX total = (INDEX) segmentSize * paths.size();
+  std::vector<CONTAINER> records(segmentSize);
+  bool ok = true;
+  for (UINT s = 0; ok && s < paths.size(); s++) {
+    for (SIZE j = 0; j < segmentSize; j++)
+      records[ j ] = (CONTAINER) (((INDEX) s * segmentSize + j + total - startIdx) % total);
+    FILE *file = fopen(paths[ s ].c_str(), "wb");
+    if (!file)
+      return false;
+    ok = fwrite(records.data(), sizeof(CONTAINER), segmentSize, file) == (size_t) segmentSize;
+    ok = fclose(file) == 0 && ok;
+  }
+  return ok;
+}
+
+// FindOldestRecord
+// Bisect over the first record of each segment for the last segment that
+// starts before the seam.  If that segment's last record is also before
+// the seam, the oldest record opens the next segment; otherwise the seam
+// is inside it and the segment is bisected.
+// Entry: log
+//        pointer to oldest (out)
+//        pointer to reads (records read, accumulated)
+// Exit: false on a failed read
+bool FindOldestRecord(
+    const SegmentLog *log,
+    LogPosition *oldest,
+    UINT *reads)
+{
+  const UINT segments = (UINT) log->sizes.size();
+  CONTAINER first, value;
+  if (!ReadLogRecord(log, { 0, 0 }, &first))
+    return false;
+  (*reads)++;
+
+  // Last segment whose first record is before the seam
+  UINT seg = 0;
+  UINT n = segments;
+  while (n > 1) {
+    UINT half = n >> 1;
+    if (!ReadLogRecord(log, { seg + half, 0 }, &value))
+      return false;
+    (*reads)++;
+    seg = (value >= first) ? seg + half : seg;
+    n -= half;
+  }
+
+  INDEX last = (INDEX) log->sizes[ seg ] - 1;
+  if (!ReadLogRecord(log, { seg, last }, &value))
+    return false;
+  (*reads)++;
+  if (value >= first) {
+    // Seam on a segment boundary
+    oldest->segment = seg + 1 < segments ? seg + 1 : 0;
+    oldest->record = 0;
+    return true;
+  }
+
+  // Last record before the seam; record 0 is and record last is not
+  INDEX base = 0;
+  INDEX m = last;
+  while (m > 1) {
+    INDEX half = m >> 1;
+    if (!ReadLogRecord(log, { seg, base + half }, &value))
+      return false;
+    (*reads)++;
+    base = (value >= first) ? base + half : base;
+    m -= half;
+  }
+  oldest->segment = seg;
+  oldest->record = base + 1;
+  return true;
+}
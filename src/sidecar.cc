@@ -0,0 +1,273 @@
+// Sidecar pivot index files and the parallel sidecar builder.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_ramp.h"
+#include "sidecar.h"
+
+// Constants
+static const char SIDECAR_SUFFIX[] = ".pivot";
+static const UINT SIDECAR_MAGIC = 0x56505246;   // "FRPV"
+static const UINT SIDECAR_VERSION = 2;     // 2: 64-bit size, start and stride
+
+// SidecarHeader
+// On-disk layout, followed by sample_count CONTAINER samples
+struct SidecarHeader {
+  UINT magic;
+  UINT version;
+  UINT element_bytes;           // sizeof(CONTAINER)
+  UINT checksum;                // FNV-1a over the header (this field 0) and samples
+  uint64_t file_bytes;          // generation stamp of the data file
+  uint64_t file_inode;
+  uint64_t file_mtime_ns;
+  uint64_t size;                // elements
+  uint64_t start;
+  uint64_t stride;
+  CONTAINER pivot_value;        // container[ pivot ]
+  CONTAINER start_value;        // container[ start ]
+  UINT sample_count;
+  UINT reserved;                // 0; keeps the header a multiple of 8 bytes
+};
+
+// Checksum
+// FNV-1a
+// Entry: pointer to bytes
+//        number of bytes
+//        running hash
+// Exit: hash
+static UINT Checksum(const void *data, size_t bytes, UINT hash = 2166136261u)
+{
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < bytes; i++)
+    hash = (hash ^ p[ i ]) * 16777619u;
+  return hash;
+}
+
+// SidecarChecksum
+// Entry: header
+//        pointer to samples
+// Exit: checksum of the header with its checksum field cleared, then the
+//       samples
+static UINT SidecarChecksum(SidecarHeader header, const CONTAINER *samples)
+{
+  header.checksum = 0;
+  UINT hash = Checksum(&header, sizeof(header));
+  return Checksum(samples, (size_t) header.sample_count * sizeof(CONTAINER), hash);
+}
+
+// StampMatches
+// Entry: header
+//        stat of the data file
+// Exit: true if the data file has the generation recorded in the header
+static bool StampMatches(const SidecarHeader &header, const struct stat &st)
+{
+  return header.file_bytes == (uint64_t) st.st_size &&
+    header.file_inode == (uint64_t) st.st_ino &&
+    header.file_mtime_ns == (uint64_t) st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+}
+
+// SidecarPath
+// Entry: path of a data file
+// Exit: path of its sidecar
+std::string SidecarPath(const char *path)
+{
+  return std::string(path) + SIDECAR_SUFFIX;
+}
+
+// WriteSidecar
+// Search a data file for its ramp start and write its sidecar.  The
+// sidecar is written to a temporary name and renamed into place, so a
+// reader sees either the old sidecar or the complete new one.
+// Entry: path of a data file
+//        pointer to start (out, may be nullptr)
+//        pointer to samples (out, may be nullptr)
+// Exit: false if the data file cannot be read or the sidecar written
+bool WriteSidecar(const char *path, INDEX *start, RampSamples *samples)
+{
+  MappedRamp ramp;
+  struct stat st;
+  if (!MapRamp(path, &ramp))
+    return false;
+  if (fstat(ramp.fd, &st)) {
+    UnmapRamp(&ramp);
+    return false;
+  }
+
+  UINT tries = 0;
+  INDEX pivot = FindRampPivotPaged(ramp.container, ramp.size, &tries);
+  INDEX found = PivotToStart(ramp.container, ramp.size, pivot);
+  INDEX stride = 1;
+  while (((INDEX) ramp.size - 1) / stride + 1 > SIDECAR_SAMPLES)
+    stride <<= 1;
+  RampSamples index;
+  index.Build(ramp.container, ramp.size, stride);
+
+  SidecarHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = SIDECAR_MAGIC;
+  header.version = SIDECAR_VERSION;
+  header.element_bytes = sizeof(CONTAINER);
+  header.file_bytes = (uint64_t) st.st_size;
+  header.file_inode = (uint64_t) st.st_ino;
+  header.file_mtime_ns = (uint64_t) st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+  header.size = (uint64_t) ramp.size;
+  header.start = found;
+  header.pivot_value = ramp.container[ found ? found - 1 : ramp.size - 1 ];
+  header.start_value = ramp.container[ found ];
+  header.stride = stride;
+  header.sample_count = (UINT) index.Samples().size();
+  header.checksum = SidecarChecksum(header, index.Samples().data());
+  UnmapRamp(&ramp);
+
+  char suffix[ 64 ];
+  snprintf(suffix, sizeof(suffix), ".tmp%d-%zx", (int) getpid(),
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+  std::string final_path = SidecarPath(path);
+  std::string tmp_path = final_path + suffix;
+  FILE *file = fopen(tmp_path.c_str(), "wb");
+  if (!file)
+    return false;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(index.Samples().data(), sizeof(CONTAINER), header.sample_count, file) == header.sample_count;
+  ok = fclose(file) == 0 && ok;
+  ok = ok && rename(tmp_path.c_str(), final_path.c_str()) == 0;
+  if (!ok) {
+    unlink(tmp_path.c_str());
+    return false;
+  }
+
+  if (start)
+    *start = found;
+  if (samples)
+    *samples = std::move(index);
+  return true;
+}
+
+// ReadSidecar
+// Read and check a sidecar against its data file: checksum, generation
+// stamp, then one read of the elements either side of the seam (two when
+// the seam is at the end of the buffer)
+// Entry: path of a data file
+//        pointer to header (out)
+//        pointer to samples (out)
+// Exit: true if the sidecar describes the data file as it is now
+static bool ReadSidecar(const char *path, SidecarHeader *header, std::vector<CONTAINER> *samples)
+{
+  FILE *file = fopen(SidecarPath(path).c_str(), "rb");
+  if (!file)
+    return false;
+  bool ok = fread(header, sizeof(*header), 1, file) == 1 &&
+    header->magic == SIDECAR_MAGIC &&
+    header->version == SIDECAR_VERSION &&
+    header->element_bytes == sizeof(CONTAINER) &&
+    header->size && header->start < header->size &&
+    header->sample_count == (header->size - 1) / (header->stride ? header->stride : 1) + 1;
+  if (ok) {
+    samples->resize(header->sample_count);
+    ok = fread(samples->data(), sizeof(CONTAINER), header->sample_count, file) == header->sample_count &&
+      SidecarChecksum(*header, samples->data()) == header->checksum;
+  }
+  fclose(file);
+  if (!ok)
+    return false;
+
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  ok = !fstat(fd, &st) && StampMatches(*header, st);
+  if (ok && header->start) {
+    CONTAINER seam[ 2 ];
+    ok = pread(fd, seam, sizeof(seam), (off_t) (header->start - 1) * sizeof(CONTAINER)) == sizeof(seam) &&
+      seam[ 0 ] == header->pivot_value && seam[ 1 ] == header->start_value;
+  } else if (ok) {
+    CONTAINER first, last;
+    ok = pread(fd, &first, sizeof(first), 0) == sizeof(first) &&
+      pread(fd, &last, sizeof(last), (off_t) (header->size - 1) * sizeof(CONTAINER)) == sizeof(last) &&
+      first == header->start_value && last == header->pivot_value;
+  }
+  close(fd);
+  return ok;
+}
+
+// LoadRampStart
+// Find the ramp start of a data file through its sidecar, falling back to
+// the page-aligned search and rewriting the sidecar when it is missing or
+// does not match
+// Entry: path of a data file
+//        pointer to start (out)
+//        pointer to samples (out, may be nullptr)
+// Exit: how the start was obtained
+SidecarResult LoadRampStart(const char *path, INDEX *start, RampSamples *samples)
+{
+  SidecarHeader header;
+  std::vector<CONTAINER> saved;
+  if (ReadSidecar(path, &header, &saved)) {
+    *start = header.start;
+    if (samples)
+      samples->Assign(header.size, header.stride, saved.data());
+    return SIDECAR_VALID;
+  }
+  return WriteSidecar(path, start, samples) ? SIDECAR_REBUILT : SIDECAR_FAILED;
+}
+
+// BuildSidecars
+// Write the sidecar of every regular file in a directory (other than
+// sidecars), spreading the files over worker threads
+// Entry: directory
+//        number of threads (0 for one per CPU)
+//        pointer to count of files that failed (out)
+// Exit: number of sidecars written
+UINT BuildSidecars(const char *dir, UINT threads, UINT *failed)
+{
+  std::vector<std::string> paths;
+  DIR *listing = opendir(dir);
+  *failed = 0;
+  if (!listing)
+    return 0;
+  const size_t suffix_len = strlen(SIDECAR_SUFFIX);
+  while (struct dirent *entry = readdir(listing)) {
+    std::string path = std::string(dir) + "/" + entry->d_name;
+    struct stat st;
+    size_t len = strlen(entry->d_name);
+    if (stat(path.c_str(), &st) || !S_ISREG(st.st_mode) ||
+        (len >= suffix_len && !strcmp(entry->d_name + len - suffix_len, SIDECAR_SUFFIX)) ||
+        strstr(entry->d_name, ".pivot.tmp"))
+      continue;
+    paths.push_back(path);
+  }
+  closedir(listing);
+
+  if (!threads)
+    threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  std::atomic<UINT> next(0), written(0), errors(0);
+  auto worker = [&]() {
+    for (UINT i; (i = next++) < paths.size();) {
+      if (WriteSidecar(paths[ i ].c_str()))
+        written++;
+      else
+        errors++;
+    }
+  };
+  std::vector<std::thread> pool;
+  for (UINT t = 1; t < threads && t < paths.size(); t++)
+    pool.emplace_back(worker);
+  worker();
+  for (std::thread &thread : pool)
+    thread.join();
+
+  *failed = errors;
+  return written;
+}
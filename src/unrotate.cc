@@ -0,0 +1,200 @@
+// Block-swap, parallel in-place unrotation.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+#include <thread>
+#include <vector>
+
+#include "unrotate.h"
+
+// CopyElements
+// Copy between non-overlapping ranges, with non-temporal stores when
+// streaming.  Stores are aligned on the destination; the source is read
+// unaligned.
+// Entry: destination
+//        source
+//        number of elements
+//        true == non-temporal stores
+static void CopyElements(CONTAINER *dst, const CONTAINER *src, SIZE n, bool stream)
+{
+  if (!stream) {
+    memcpy(dst, src, n * sizeof(CONTAINER));
+    return;
+  }
+  SIZE i = 0;
+  for (; i < n && ((uintptr_t) (dst + i) & 15); i++)
+    dst[ i ] = src[ i ];
+  for (; i + 4 <= n; i += 4)
+    _mm_stream_si128((__m128i *) (dst + i), _mm_loadu_si128((const __m128i *) (src + i)));
+  for (; i < n; i++)
+    dst[ i ] = src[ i ];
+}
+
+// RunSplit
+// Run a function over count elements, split into one contiguous range per
+// thread when count reaches UNROTATE_PARALLEL.  Range t is
+// [ count * t / ranges, count * (t + 1) / ranges ), so none is shorter
+// than count / ranges.
+// Entry: number of elements
+//        number of threads
+//        function taking (range index, first element, end element)
+template <typename F>
+static void RunSplit(SIZE count, UINT threads, F f)
+{
+  UINT ranges = count >= UNROTATE_PARALLEL ? threads : 1;
+  auto run = [&](UINT t) {
+    f(t, count * t / ranges, count * (t + 1) / ranges);
+  };
+  std::vector<std::thread> pool;
+  for (UINT t = 1; t < ranges; t++)
+    pool.emplace_back(run, t);
+  run(0);
+  for (std::thread &thread : pool)
+    thread.join();
+}
+
+// SwapBlocks
+// Swap two non-overlapping ranges.  Both destinations have just been
+// read, so stores go through the caches.
+// Entry: first range
+//        second range
+//        number of elements in each
+//        number of threads
+static void SwapBlocks(CONTAINER *x, CONTAINER *y, SIZE n, UINT threads)
+{
+  RunSplit(n, threads, [&](UINT, SIZE lo, SIZE hi) {
+    std::swap_ranges(x + lo, x + hi, y + lo);
+  });
+}
+
+// ShiftElements
+// Move count elements by a distance of at most UNROTATE_BUFFER, the
+// ranges overlapping.  In parallel, each range first saves the elements
+// the neighbouring range's destination overwrites (the last distance of
+// each range moving down, the first distance moving up), then moves the
+// rest of itself and writes the saved elements last.
+// Entry: destination
+//        source
+//        number of elements
+//        number of threads
+static void ShiftElements(CONTAINER *dst, CONTAINER *src, SIZE count, UINT threads)
+{
+  const SIZE dist = dst < src ? src - dst : dst - src;
+  if (count < UNROTATE_PARALLEL || count / threads < 2 * dist) {
+    memmove(dst, src, count * sizeof(CONTAINER));
+    return;
+  }
+  const bool down = dst < src;
+  std::vector<CONTAINER> saved((size_t) threads * dist);
+  for (UINT t = 0; t < threads; t++) {
+    SIZE lo = count * t / threads;
+    SIZE hi = count * (t + 1) / threads;
+    if (down ? hi < count : lo > 0)
+      memcpy(&saved[ (size_t) t * dist ], src + (down ? hi - dist : lo), dist * sizeof(CONTAINER));
+  }
+  RunSplit(count, threads, [&](UINT t, SIZE lo, SIZE hi) {
+    if (down ? hi == count : lo == 0) {
+      memmove(dst + lo, src + lo, (hi - lo) * sizeof(CONTAINER));
+      return;
+    }
+    SIZE keep = down ? lo : lo + dist;
+    memmove(dst + keep, src + keep, (hi - lo - dist) * sizeof(CONTAINER));
+    memcpy(dst + (down ? hi - dist : lo), &saved[ (size_t) t * dist ], dist * sizeof(CONTAINER));
+  });
+}
+
+// UnrotateContainer
+// Rotate a container in place so the ramp starts at index 0: while both
+// sides are longer than UNROTATE_BUFFER, swap the shorter side with the
+// far end of the longer one, which leaves it in its final place; then
+// move the shorter side through a buffer and shift the longer one past it
+// Entry: pointer to container
+//        size of container
+//        ramp start (from FindRampStart)
+//        number of threads (0 for one per CPU)
+void UnrotateContainer(CONTAINER *container, SIZE size, INDEX start, UINT threads)
+{
+  if (size < 2 || !start || (SIZE) start >= size)
+    return;
+  if (!threads)
+    threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+  // p[ 0 .. a ) is to follow p[ a .. a + b )
+  CONTAINER *p = container;
+  SIZE a = (SIZE) start;
+  SIZE b = size - a;
+  while (a > UNROTATE_BUFFER && b > UNROTATE_BUFFER) {
+    if (a <= b) {
+      // a b1 b2 -> b2 b1 a; b2 b1 remains to rotate
+      SwapBlocks(p, p + b, a, threads);
+      b -= a;
+    } else {
+      // a1 a2 b -> b a2 a1; a2 a1 remains to rotate
+      SwapBlocks(p, p + a, b, threads);
+      p += b;
+      a -= b;
+    }
+  }
+  if (!a || !b)
+    return;
+
+  std::vector<CONTAINER> buffer(std::min(a, b));
+  if (a <= b) {
+    memcpy(buffer.data(), p, a * sizeof(CONTAINER));
+    ShiftElements(p, p + a, b, threads);
+    memcpy(p + b, buffer.data(), a * sizeof(CONTAINER));
+  } else {
+    memcpy(buffer.data(), p + a, b * sizeof(CONTAINER));
+    ShiftElements(p + b, p, a, threads);
+    memcpy(p, buffer.data(), b * sizeof(CONTAINER));
+  }
+}
+
+// UnrotateCopy
+// Write a rotated container in sorted order to another buffer.  The
+// destination is only written, so from UNROTATE_STREAM elements the
+// stores are non-temporal and skip reading each destination line first.
+// Entry: pointer to destination (size elements, not overlapping)
+//        pointer to container
+//        size of container
+//        ramp start (from FindRampStart)
+//        number of threads (0 for one per CPU)
+void UnrotateCopy(CONTAINER *dst, const CONTAINER *container, SIZE size, INDEX start, UINT threads)
+{
+  if (size < 1)
+    return;
+  if (!threads)
+    threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  const bool stream = size >= UNROTATE_STREAM;
+  const SIZE head = size - (SIZE) start;
+  RunSplit(size, threads, [&](UINT, SIZE lo, SIZE hi) {
+    // dst[ 0 .. head ) from container[ start .. size ), the rest from the front
+    if (lo < head)
+      CopyElements(dst + lo, container + start + lo, std::min(hi, head) - lo, stream);
+    if (hi > head)
+      CopyElements(dst + std::max(lo, head), container + (std::max(lo, head) - head),
+          hi - std::max(lo, head), stream);
+    if (stream)
+      _mm_sfence();
+  });
+}
+
+// UnrotateRamp
+// Find the ramp start and unrotate the container so it is sorted
+// Entry: pointer to container
+//        size of container
+//        engine for the start search
+//        number of threads (0 for one per CPU)
+// Exit: ramp start the container was rotated from
+INDEX UnrotateRamp(CONTAINER *container, SIZE size, PivotEngine engine, UINT threads)
+{
+  if (size < 1)
+    return 0;
+  UINT tries = 0;
+  INDEX start = FindRampStart(container, size, &tries, engine);
+  UnrotateContainer(container, size, start, threads);
+  return start;
+}
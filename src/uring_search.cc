@@ -0,0 +1,309 @@
+// Direct-I/O pivot search: pread bisection and the io_uring k-ary search.
+//
+// Copyright (C) 2018 Gregory Hedger
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "uring_search.h"
+
+// Elements per block
+static const UINT BLOCK_ELEMENTS = URING_BLOCK / sizeof(CONTAINER);
+
+// OpenRampFile
+// Open a file of native-endian CONTAINER values for direct I/O
+// Entry: path
+//        pointer to file (out)
+// Exit: false if the file cannot be opened or holds no whole element
+bool OpenRampFile(const char *path, RampFile *file)
+{
+  struct stat st;
+  file->fd = open(path, O_RDONLY | O_DIRECT);
+  if (file->fd < 0)
+    return false;
+  if (fstat(file->fd, &st) || st.st_size < (off_t) sizeof(CONTAINER)) {
+    close(file->fd);
+    return false;
+  }
+  file->bytes = (size_t) st.st_size;
+  file->size = (SIZE) (file->bytes / sizeof(CONTAINER));
+  return true;
+}
+
+// CloseRampFile
+// Entry: pointer to file
+void CloseRampFile(RampFile *file)
+{
+  close(file->fd);
+  file->fd = -1;
+}
+
+// UringInit
+// Set up a ring and its read buffers
+// Entry: pointer to ring (out)
+//        number of reads kept in flight
+// Exit: false if io_uring is unavailable
+bool UringInit(Uring *ring, UINT entries)
+{
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd < 0)
+    return false;
+  ring->entries = params.sq_entries;
+
+  ring->sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single) {
+    if (ring->cq_ring_bytes > ring->sq_ring_bytes)
+      ring->sq_ring_bytes = ring->cq_ring_bytes;
+    ring->cq_ring_bytes = ring->sq_ring_bytes;
+  }
+  ring->sq_ring = mmap(nullptr, ring->sq_ring_bytes, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  ring->cq_ring = single ? ring->sq_ring : mmap(nullptr, ring->cq_ring_bytes,
+      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+  ring->sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, ring->sqes_bytes, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  ring->buffers = static_cast<unsigned char *>(aligned_alloc(URING_BLOCK, (size_t) ring->entries * URING_BLOCK));
+  if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || sqes == MAP_FAILED || !ring->buffers) {
+    ring->sqes = sqes == MAP_FAILED ? nullptr : static_cast<io_uring_sqe *>(sqes);
+    UringExit(ring);
+    return false;
+  }
+  ring->sqes = static_cast<io_uring_sqe *>(sqes);
+
+  unsigned char *sq = static_cast<unsigned char *>(ring->sq_ring);
+  unsigned char *cq = static_cast<unsigned char *>(ring->cq_ring);
+  ring->sq_head = (unsigned *) (sq + params.sq_off.head);
+  ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+  ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+  ring->cqes = (io_uring_cqe *) (cq + params.cq_off.cqes);
+  return true;
+}
+
+// UringExit
+// Entry: pointer to ring
+void UringExit(Uring *ring)
+{
+  if (ring->sqes)
+    munmap(ring->sqes, ring->sqes_bytes);
+  if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_bytes);
+  if (ring->sq_ring && ring->sq_ring != MAP_FAILED)
+    munmap(ring->sq_ring, ring->sq_ring_bytes);
+  free(ring->buffers);
+  if (ring->fd >= 0)
+    close(ring->fd);
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+}
+
+// UringReadBlocks
+// Read blocks into the ring's buffers, buffer j receiving blocks[ j ], and
+// wait for all of them: one round trip.  If io_uring_enter fails, the
+// reads already submitted are still waited for, so none completes into a
+// later call; if reads are left unsubmitted in the queue, or waiting fails
+// too, the ring is torn down and later calls fail until it is set up
+// again.
+// Entry: pointer to ring
+//        file
+//        block numbers
+//        number of blocks (<= ring entries)
+//        pointer to bytes read per block (out)
+// Exit: false on a failed read
+static bool UringReadBlocks(Uring *ring, const RampFile *file, const INDEX *blocks, UINT count, int *lengths)
+{
+  if (ring->fd < 0)
+    return false;
+  unsigned tail = *ring->sq_tail;
+  for (UINT j = 0; j < count; j++) {
+    unsigned idx = tail & *ring->sq_mask;
+    io_uring_sqe *sqe = &ring->sqes[ idx ];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = file->fd;
+    sqe->addr = (unsigned long) (ring->buffers + (size_t) j * URING_BLOCK);
+    sqe->len = URING_BLOCK;
+    sqe->off = blocks[ j ] * URING_BLOCK;
+    sqe->user_data = j;
+    ring->sq_array[ idx ] = idx;
+    tail++;
+  }
+  __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+  UINT done = 0;
+  UINT submitted = 0;
+  bool ok = true;
+  bool failed = false;
+  while (done < (failed ? submitted : count)) {
+    // After a failure, only wait for the reads the kernel has taken
+    long ret = syscall(__NR_io_uring_enter, ring->fd, failed ? 0 : count - submitted,
+        (failed ? submitted : count) - done, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret < 0 && failed) {
+      UringExit(ring);
+      return false;
+    }
+    if (ret < 0) {
+      failed = true;
+      continue;
+    }
+    submitted += (UINT) ret;
+    unsigned head = *ring->cq_head;
+    unsigned cq_tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != cq_tail; head++) {
+      const io_uring_cqe *cqe = &ring->cqes[ head & *ring->cq_mask ];
+      lengths[ cqe->user_data ] = cqe->res;
+      ok = ok && cqe->res >= (int) sizeof(CONTAINER);
+      done++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  }
+  if (failed && submitted < count)
+    UringExit(ring);
+  return ok && !failed;
+}
+
+// LastHigh
+// Entry: pointer to a block's elements, the first before the seam
+//        number of valid elements
+//        container[ 0 ]
+// Exit: index in the block of the last element before the seam
+static UINT LastHigh(const CONTAINER *base, UINT n, CONTAINER first)
+{
+  const CONTAINER *lo = base;
+  while (n > 1) {
+    UINT half = n >> 1;
+    lo = (lo[ half ] >= first) ? lo + half : lo;
+    n -= half;
+  }
+  return (UINT) (lo - base);
+}
+
+// FindRampPivotPread
+// Branchless bisection as FindRampPivotBranchless, reading the block that
+// holds each probe with a blocking pread.  Once the window is inside the
+// block last read, the remaining levels need no I/O.
+// Entry: file
+//        pointer to tries (reads issued)
+// Exit: pivot, ~0 on a failed allocation or read
+INDEX FindRampPivotPread(
+    const RampFile *file,
+    UINT *tries)
+{
+  CONTAINER *block = static_cast<CONTAINER *>(aligned_alloc(URING_BLOCK, URING_BLOCK));
+  if (!block)
+    return ~(INDEX) 0;
+  INDEX cached = ~(INDEX) 0;
+  bool ok = true;
+  auto element = [&](INDEX idx) {
+    INDEX b = idx / BLOCK_ELEMENTS;
+    if (b != cached) {
+      ok = ok && pread(file->fd, block, URING_BLOCK, (off_t) b * URING_BLOCK) >= (ssize_t) sizeof(CONTAINER);
+      cached = b;
+      (*tries)++;
+    }
+    return block[ idx % BLOCK_ELEMENTS ];
+  };
+
+  const CONTAINER first = element(0);
+  INDEX base = 0;
+  INDEX n = file->size;
+  while (ok && n > 1) {
+    INDEX half = n >> 1;
+    base = (element(base + half) >= first) ? base + half : base;
+    n -= half;
+  }
+  free(block);
+  return ok ? base : ~(INDEX) 0;
+}
+
+// FindRampPivotUring
+// k-ary search over blocks.  The window [lo, lo + n) of blocks holds the
+// last block whose first element is before the seam, and block lo, whose
+// elements are kept, starts before the seam.  Each round reads ways - 1
+// blocks spread evenly over the window at once; those starting before
+// the seam give the new lo.  The search ends as soon as block lo holds
+// the seam or is the only block left.
+// Entry: pointer to ring
+//        file
+//        blocks per round + 1 (2..URING_MAX_WAYS, clamped to the ring)
+//        pointer to round trips (out, accumulated)
+//        pointer to blocks read (out, accumulated; may be nullptr)
+// Exit: pivot, ~0 on a failed read
+INDEX FindRampPivotUring(
+    Uring *ring,
+    const RampFile *file,
+    UINT ways,
+    UINT *rounds,
+    UINT *reads)
+{
+  ways = ways < 2 ? 2 : ways;
+  ways = ways > URING_MAX_WAYS ? URING_MAX_WAYS : ways;
+  ways = ways > ring->entries + 1 ? ring->entries + 1 : ways;
+  const INDEX blocks = (file->bytes + URING_BLOCK - 1) / URING_BLOCK;
+  INDEX probes[ URING_MAX_WAYS ];
+  int lengths[ URING_MAX_WAYS ];
+  alignas(64) CONTAINER lo_data[ BLOCK_ELEMENTS ];
+  UINT lo_count;
+  UINT issued = 0;
+
+  probes[ 0 ] = 0;
+  (*rounds)++;
+  issued++;
+  if (!UringReadBlocks(ring, file, probes, 1, lengths)) {
+    if (reads)
+      *reads += issued;
+    return ~(INDEX) 0;
+  }
+  lo_count = (UINT) lengths[ 0 ] / sizeof(CONTAINER);
+  memcpy(lo_data, ring->buffers, lo_count * sizeof(CONTAINER));
+  const CONTAINER first = lo_data[ 0 ];
+
+  INDEX lo = 0;
+  INDEX n = blocks;
+  while (n > 1 && lo_data[ lo_count - 1 ] >= first) {
+    INDEX step = n / ways ? n / ways : 1;
+    UINT count = 0;
+    for (UINT j = 1; j < ways && j * step < n; j++)
+      probes[ count++ ] = lo + j * step;
+    (*rounds)++;
+    issued += count;
+    if (!UringReadBlocks(ring, file, probes, count, lengths)) {
+      if (reads)
+        *reads += issued;
+      return ~(INDEX) 0;
+    }
+
+    UINT high = 0;
+    for (UINT j = 0; j < count; j++) {
+      const CONTAINER *head = (const CONTAINER *) (ring->buffers + (size_t) j * URING_BLOCK);
+      high += head[ 0 ] >= first;
+    }
+    if (high) {
+      lo_count = (UINT) lengths[ high - 1 ] / sizeof(CONTAINER);
+      memcpy(lo_data, ring->buffers + (size_t) (high - 1) * URING_BLOCK, lo_count * sizeof(CONTAINER));
+    }
+    n = high == count ? n - high * step : step;
+    lo += high * step;
+  }
+  if (reads)
+    *reads += issued;
+  return lo * BLOCK_ELEMENTS + LastHigh(lo_data, lo_count, first);
+}